@@ -13,6 +13,9 @@
 /********************************************************************
  *  File scope declarations revision history:
  *    11-22-21 jmh:  creation date (modified to support GPSDO, MK-II)
+ *    10-17-26 jmh:  SPI0 on the crossbar (3-wire master, CKPHA = 1, ~2 MHz), Timer0 intr off
+ *    10-17-26 jmh:  SPI0 intr on (spi.c job queue)
+ *    10-17-26 jmh:  PCA overflow intr on (ECF, high word of the capture timestamps)
  *
  *******************************************************************/
 
@@ -29,7 +32,7 @@ void PCA_Init()
 {
     PCA0CN    = 0x40;
     PCA0MD    &= ~0x40;
-    PCA0MD    = 0x08;
+    PCA0MD    = 0x09;
     PCA0CPM0  = 0x21;
     PCA0CPM1  = 0x43;
     PCA0CPM2  = 0x21;
@@ -57,16 +60,16 @@ void UART_Init()
 
 void SPI_Init()
 {
-    SPI0CFG   = 0x40;
-    SPI0CN    = 0x00;
-    SPI0CKR   = 0x79;
+    SPI0CFG   = 0x60;
+    SPI0CN    = 0x01;
+    SPI0CKR   = 0x05;
 }
 
 void Port_IO_Init()
 {
-    // P0.0  -  Skipped,     Push-Pull,  Digital
-    // P0.1  -  Skipped,     Open-Drain, Digital
-    // P0.2  -  Skipped,     Push-Pull,  Digital
+    // P0.0  -  SCK  (SPI0), Push-Pull,  Digital
+    // P0.1  -  MISO (SPI0), Open-Drain, Digital
+    // P0.2  -  MOSI (SPI0), Push-Pull,  Digital
     // P0.3  -  CEX0  (PCA), Open-Drain, Digital
     // P0.4  -  TX   (UART), Push-Pull,  Digital
     // P0.5  -  RX   (UART), Open-Drain, Digital
@@ -84,9 +87,8 @@ void Port_IO_Init()
 
     P0MDOUT   = 0x55;
     P1MDOUT   = 0xFF;
-    P0SKIP    = 0x07;
-    P0SKIP    |= 0x30;
-    XBR0      = 0x01;
+    P0SKIP    = 0x30;
+    XBR0      = 0x03;
     XBR1      = 0x43;
 }
 
@@ -98,7 +100,7 @@ void Oscillator_Init()
 void Interrupts_Init()
 {
     EIE1      = 0x04;
-    IE        = 0x32;
+    IE        = 0x70;
 }
 
 // Initialization function for device,
@@ -44,7 +44,7 @@ void init_flash(void)
 }
 
 //-----------------------------------------------------------------------------
-// find last flash write 
+// find last flash write (0xffff if the scratchpad is empty)
 //-----------------------------------------------------------------------------
 U16 find_flash(void)
 {
@@ -61,7 +61,7 @@ bit		b = 1;
 			}
 		}
 	}
-	if(!addr) addr -= 1;
+	addr -= 1;										// first empty -> last written
 	return addr;
 }
 
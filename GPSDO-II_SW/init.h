@@ -13,6 +13,25 @@
 /********************************************************************
  *  File scope declarations revision history:
  *    11-22-21 jmh:  creation date (modified to support GPSDO, MK-II)
+ *    10-17-26 jmh:  loop parameter block (KP, KPD, AVE_COUNT, GPS_TIMEOUT) may be
+ *                   overridden from the build (gpsdo_tune emits a replacement)
+ *    10-17-26 jmh:  TP_QERR
+ *    10-17-26 jmh:  GPS_TS, PCA_HALF
+ *    10-17-26 jmh:  PCA_FUSE and the PCA/TIM-TM2 fusion constants, DIV_MS
+ *    10-17-26 jmh:  MARK_NMAX, PCA_DIV
+ *    10-17-26 jmh:  divider period at run time: DIV_MS is the default, DIV_MS_MAX, MARK_MS and PCA_MS
+ *					 replace MARK_NMAX and PCA_DIV
+ *    10-17-26 jmh:  AQS_KP/AQS_KPD, AQS_SH, AQS_LIM, AQS_NMIN, AQS_MAX, AQS_TN
+ *    10-17-26 jmh:  KP/KPD is the TRACK PI damping, PI_TAU0/PI_TAU1 (overridable), PI_LOCK, PI_SLIP,
+ *					 PI_PHMAX, PI_DMAX, PI_TMAX
+ *    10-17-26 jmh:  KF_M0, KF_M, KF_DMAX, KF_DRMAX
+ *    10-17-26 jmh:  ACC_K, ACC_NREJ, ACC_DEG, ACC_LEAK
+ *    10-17-26 jmh:  PI_TMAX removed
+ *    10-17-26 jmh:  FUSE_LIM
+ *    10-17-26 jmh:  LQ_SH, LQ_PFAIR, LQ_YFAIR, LQ_PGOOD, LQ_YGOOD
+ *    10-17-26 jmh:  PCA_FUSE, FUSE_SH, FUSE_N, FUSE_WIN, FUSE_LIM, PCA_NS_Q8, PCA_MID removed
+ *    10-17-26 jmh:  TP_QERR is applied by getm()
+ *    10-17-26 jmh:  LQ_MSH
  *
  *******************************************************************/
 
@@ -81,7 +100,6 @@
 #define	FAN_OFF			0x02
 #define	FAN_ON_TIME		500	//10MS10000
 #define	TEMP_TIMER		MS1000
-#define	GPS_TIMEOUT		(MS12500)
 // ERROR LED defines
 #define	BLINK_RATE		MS1000
 #define	BLINK_100		(BLINK_RATE)
@@ -104,12 +122,13 @@
 // cflag bitmap
 #define	GPS_TP			0x01
 #define	DIV_TP			0x02
-#define	TP_RDY			0x04
+#define	TP_RDY			0x04			// pca_ph is new
 #define	MASK_TP			(GPS_TP | DIV_TP | TP_RDY)
+#define	GPS_TS			0x08			// gts is valid
 #define	GPSTPS			0x10			// GPS IPL activities executed
 #define	GPSFINE			0x20			// GPS fine mode active
 #define	PPMFAIR			0x40
-#define	PPMGOOD			0x80			// VCO loop health flags
+#define	PPMGOOD			0x80			// VCO loop health flags (lock quality, lq_step())
 
 //AD5761 DAC defines
 #define	DAC_NOP			0x0				// no-operation
@@ -157,7 +176,55 @@
 #define	VCO_DR1		0x21
 #define	VCO_DR2		0x22
 
-#define	AVE_COUNT	5
+// VCO loop parameters
+#ifndef	KP
+#define	KP			1264L			// TRACK damping, KP/KPD x the critically damped P gain (2 G / tau)
+#define	KPD			1000L
+#endif
+#ifndef	AVE_COUNT
+#define	AVE_COUNT	5				// longest TRACK window (DAC update), in DIV_MS periods
+#endif
+#ifndef	PI_TAU0
+#define	PI_TAU0		40L				// TRACK loop time constant out of AQS, s..
+#define	PI_TAU1		640L			// ..doubled up to this while the phase holds
+#endif
+#define	PI_LOCK		200L			// ns, |phase| within this for 2 tau: tau doubles
+#define	PI_SLIP		(PI_LOCK * 4L)	// ns, |phase| past this: tau halves
+#define	PI_PHMAX	8000L			// ns, phase the integrator sees, max
+#define	PI_DMAX		4000L			// ns, phase change per update, max
+#define	KF_M0		3				// clock-state estimator gains 2^-KF_M0 out of AQS..
+#define	KF_M		7				// ..narrowing to 2^-KF_M (memory about 2^KF_M periods)
+#define	KF_DMAX		2000L			// ns, time-mark change (and innovation) the estimator takes, max
+#define	KF_DRMAX	(1L << 28)		// drift estimate, max (1 ns per period^2, Q28)
+#define	ACC_K		4L				// a time-mark residual over ACC_K x its accEst is an outlier..
+#define	ACC_NREJ	3				// ..unless ACC_NREJ came before it in a row (the phase stepped)
+#define	ACC_DEG		4L				// accEst over ACC_DEG x the accEst floor: degraded, the mark isn't used
+#define	ACC_LEAK	8				// the accEst floor rises 2^-ACC_LEAK per mark toward the reported accEst
+#define	LQ_SH		4				// lock quality: TRACK phase and frequency error averaged over 2^LQ_SH updates
+#define	LQ_PFAIR	1000L			// ns, PPMFAIR below this average |phase| error..
+#define	LQ_YFAIR	5000L			// ..and |frequency| error (1e-12, AQS_LIM), cleared past 2x
+#define	LQ_PGOOD	100L			// PPMGOOD, the same (1 DAC LSB is about 350e-12, the loop
+#define	LQ_YGOOD	500L			//  dithers the frequency over that)
+#define	LQ_MSH		6				// a TRACK mark not used steps the phase average 2^-LQ_MSH toward 4x LQ_PFAIR
+#ifndef	GPS_TIMEOUT
+#define	GPS_TIMEOUT		(MS12500)	// no valid time-mark for this long: DR mode
+#endif
+#ifndef	TP_QERR
+#define	TP_QERR		0				// 1 = getm() adds the TIM-TP qErr of the matching pulse to each time-mark
+#endif								//  (the mark is latched on the receiver clock, which qErr doesn't describe:
+									//  gpsdo_sim fw.qerr=1 shows ADEV below 100 s getting worse, so off)
+#define	AQS_KP		100L			// AQS DAC tuning gain, AQS_KP/AQS_KPD DAC LSB per ns of time-mark change per DIV_MS
+#define	AQS_KPD		175L			//  (the starting value, each AQS jump measures it)
+#define	AQS_SH		12				// AQS gain (aqs_g) is Q12
+#define	AQS_LIM		25L				// ns of time-mark change per DIV_MS, AQS hands over to TRACK at or below..
+#define	AQS_NMIN	15L				// ..but not below this (ns per period, TIM-TM2 noise)
+#define	AQS_MAX		4				// AQS jumps before TRACK takes over regardless
+#define	AQS_TN		4				// longest gap (periods) AQS measures across
+#define	DIV_MS		5000L			// ms between divider edges (TIM-TM2 marks) until tm2_per is measured
+#define	DIV_MS_MAX	60000L			// longest divider period taken from TIM-TM2
+#define	MARK_MS		120000L			// longest gap TRACK steps across (missed marks), ms
+#define	PCA_HALF	(SYSCLK / 2L)	// PCA counts (SYSCLK) in half a second
+#define	PCA_MS		(SYSCLK / 1000L)	// PCA counts per ms
 #define	MIN_MAX_COUNT	10
 #define	DAC_HOLD_COUNT	1
 #define	MAX_MARK	(1000000L)
@@ -16,6 +16,49 @@
  *
  *
  *  Project scope revision history:
+ *    10-17-26 jmh:  kf_hold() nulls kf_y from kf_dac, the code it was estimated at; kf_step() cycle count.
+ *    10-17-26 jmh:  The accEst floor starts over (acc_init()) on each AQS entry, and TRACK marks that
+ *					 are not used wear PPMGOOD/PPMFAIR down (lq_miss()).
+ *    10-17-26 jmh:  IRAM budget (see the resource notes): the values set_period() kept are worked out
+ *					 where used (gps_rst(), ave_win(), aqs_nlim(), pi_tlim()), pca_div and the kf_step()
+ *					 saves are gone, lq_ph/lq_y and pi_ph are 16 bits, tec_step() out of main().
+ *    10-17-26 jmh:  div_ms gone, tm2_per is the period and tm2_new flags a change.  The TIM-TP qErr
+ *					 correction (TP_QERR) is done by getm(), qerr_tt() and qerr_ns() are gone.
+ *    10-17-26 jmh:  PCA/TIM-TM2 fusion (PCA_FUSE) removed: no ADEV gain at any tau, and its state
+ *					 didn't fit the F531's idata.  TRACK steps on TIM-TM2 only.
+ *    10-17-26 jmh:  dph gone, the kf_step() result goes straight into avett.
+ *    10-17-26 jmh:  lq_ph, lq_y in the TRACK state (vm).
+ *    10-17-26 jmh:  accEst state in idata, acc_lim S16.
+ *    10-17-26 jmh:  PCA-fused marks and their true-ups are gated on FUSE_LIM, not in acc_nrej.
+ *    10-17-26 jmh:  AQS, TRACK and DR state share idata (vm), kf_f is U16.
+ *    10-17-26 jmh:  pi_step() integrates all n periods of an update (PI_TMAX is gone).
+ *    10-17-26 jmh:  Fusion, period, AQS and PI state in idata (aqs_lim, pi_rp S16).
+ *    10-17-26 jmh:  deldac removed (set, never read since AQS stopped the binary search).
+ *    10-17-26 jmh:  Lock quality (lq_step()): TRACK phase and frequency error averages set PPMFAIR and
+ *					 PPMGOOD and the ERROR LED duty cycle.
+ *    10-17-26 jmh:  TIM-TM2 accEst: marks are weighted by it (acc_chk()), degraded ones and outliers are
+ *					 not used (acc_ndeg, acc_nrej).
+ *    10-17-26 jmh:  Clock-state estimator (kf_step(): phase, frequency, drift) on the TRACK time-marks.
+ *					 TRACK runs the PI loop on its phase, DR2/DR1 steer the DAC on its frequency and
+ *					 drift (kf_hold(), kf_coast()).
+ *    10-17-26 jmh:  TRACK is a PI loop on the unwrapped phase (pi_step()), its time constant goes from
+ *					 PI_TAU0 to PI_TAU1 while the phase holds.  KP/KPD is its damping, kpd is gone.
+ *    10-17-26 jmh:  AQS jumps the DAC on the measured time-mark slope (aqs_est()) instead of the binary
+ *					 search, and the cold start (TRACK2) goes through it.  AQS had the sign of tt - tto
+ *					 backwards (TRACK has it right).
+ *    10-17-26 jmh:  Divider period at run time (tm2_per, set_period()), the values that depend on it
+ *					 are derived from it.  TRACK windows start at one period and double to AVE_COUNT * DIV_MS.
+ *    10-17-26 jmh:  TRACK steps across missed time-marks: the divider periods since tto come from the
+ *					 mark times (tm2_ms, PCA timestamps) and avett is averaged over the periods it spans.
+ *    10-17-26 jmh:  TRACK fuses the PCA phase with TIM-TM2 (PCA_FUSE): the loop steps at the divider edge
+ *					 on the PCA phase, the TIM-TM2 of that edge trues the step up and trains the bias.
+ *    10-17-26 jmh:  PCA captures extended to 32-bit timestamps (ovrflo_count is the high word), the
+ *					 GPS-vs-divider phase (pca_ph) is formed in pca_intr() at the edge.
+ *    10-17-26 jmh:  TIM-TP qErr (sawtooth) correction of the TRACK time-marks (TP_QERR).
+ *    10-17-26 jmh:  DAC writes and temperature reads go through the SPI0 job queue (spi.c), the main loop
+ *					 no longer waits on the bus.
+ *    10-17-26 jmh:  DS1722 and AD5761 moved from the Timer0 bit-bang to the SPI0 peripheral.
+ *    10-17-26 jmh:  KP/KPD moved to init.h with the other loop parameters.
  *    11-24-21 jmh:  Initial project functionality coded.  Temperature, DAC, UART, and LEDs all functional.
  *					 Coded the begninings of control loops for the VCO and TEC.
  *    11-22-21 jmh:  Project origin, copied from HM133
@@ -30,17 +73,41 @@
 //
 //      UART: GPS command I/O
 //
-//      Timer0: bbSPI clock driver
+//      SPI0: DS1722 temp sensor and AD5761 DAC (3-wire master, ~2 MHz, intr driven job queue)
+//
+//      Timer0: n/u
 //      Timer1: UART baud clock (38400 baud)
 //      Timer2: Application timer (10ms/tic)
 //
 //      ADC: n/u
 //
-//      PCA: 
+//      PCA: SYSCLK (40.8 ns/count), overflow intr extends the captures to 32 bits (175 s)
 //			 CEX0 = GPS time pulse
 //			 CEX1 = fan pwm out (pwm mode also used for on-off control)
 //			 CEX2 = vco divider time pulse (deprecated)
 //
+//      IRAM: 256 bytes.  Small model at OPTIMIZE(2), so locals and parameters are in
+//			 overlaid data, not registers.  GPSDO_II.uvproj packs IDATA after DATA (no
+//			 IDATA base) and overlays write_flast() into main()'s tree (it is not called);
+//			 STARTUP.A51 clears all 256.  Bytes:
+//
+//			 register banks 0 and 2 (every ISR is "using 2"; 1 and 3 hold data)	 16
+//			 bits: main.c 6, serial.c 6, spi.c 1, flash.c 1						  2
+//			 main.c	 timers, blink regs, ovrflo_count, gts, dts, pca_ph, cflag	 25
+//					 aqs_g 2, vm 30, kf_y/kf_d 8, acc_* 10, dac_job/ts_job 12	 62
+//					 main(): dac, tt, aa, tto, avett 16 (data), i, vco_state,
+//					 tn, ave_n, ecount, ttms 9 (idata)							 25
+//			 serial.c rxd_intr() state and drop counters						 15
+//					 rxd_tm2 20, rxd_aux 8, tm2_* 9, tp_s/tp_q 6, nav_* 2		 45
+//			 spi.c	 spi_qhead/qtail/idx 3, spi_q 4								  7
+//			 overlay	 deepest path from main(): getm() 4, tm2_msg() 13,
+//					 tp_qerr() 2 (pi_step() 17 + pi_tlim() 2 is the same)		 19
+//			 ISRs	 rxd_intr() c, i 2, pca_intr() c, h 4						  6
+//			 static total														222
+//			 stack: main() 5 calls deep (kf_hold() .. spi_start()) plus the
+//			 C51 long math, 14; one ISR frame (low priority, none nest), 9		 23
+//			 spare																 11
+//
 //      SYSTEM NOTES:
 //
 //		This project drives a VCO and TEC stack to both temperature and frequency stabilize
@@ -53,6 +120,13 @@
 //		as 5 sec, or as short as 1 sec.  Error (YEL) blinks at a 1 sec rate with a variable duty
 //		cycle to denote the level of error.  Steady on is the maximum error state (no GPS pulses),
 //		while steady off is the minimum error state (VCO stability within a set tolerance).
+//		AQS is 50%.  In TRACK the duty follows the lock quality: the loop phase error (pi_ph) and
+//		the frequency error (kf_y) are averaged over 2^LQ_SH updates, each is BLINK_10 per fair
+//		limit (LQ_PFAIR, LQ_YFAIR) and the LED shows the larger, from 1% to 49%.  With both under
+//		the fair limits PPMFAIR is set in cflag, under the good limits (LQ_PGOOD, LQ_YGOOD) PPMGOOD,
+//		and only then does the LED go off.  Either average past 2x its limit clears the flag; DR clears both.
+//		A mark TRACK can't use (degraded or an outlier) steps the phase average up (lq_miss()), so the
+//		flags don't outlive the marks that set them.
 //
 //		Using a divider toggle period of 5 sec, the conversion ratio calculates to be about 100/175 DACLSBs/ns
 //		to get an approximate solution to close the loop.  Reading this time directly from the GPS time-mark
@@ -60,6 +134,45 @@
 //
 //			deldac = delta(tt) * 100 / 175
 //
+//		The ratio goes as 1/period, set_period() scales it to the divider period measured from TIM-TM2
+//		(tm2_per).  AQS steps on every divider edge.
+//
+//		AQS uses the same conversion the other way: the time-mark change over one period is the
+//		frequency error, times AQS_KP/AQS_KPD is the DAC change that nulls it.  Each jump is then
+//		measured on the next mark, which gives the VCO's own gain (aqs_g) for the next jump.  With
+//		the gain within 2x of the starting value that is 2 or 3 marks to AQS_LIM, where TRACK takes
+//		over.
+//
+//		TRACK is a PI loop on the phase (sum of the time-mark changes since TRACK came up).  With G the
+//		VCO gain (aqs_g, DAC LSB per ns/period) and tau the loop time constant in periods, each update
+//		moves the DAC by
+//
+//			deldac = (KP/KPD) * 2 * G * delta(phase) / tau  +  G * phase * periods / tau^2
+//
+//		which is a critically damped second order loop at KP/KPD = 1.  It is the velocity form: the DAC
+//		is the integrator, so there is nothing to wind up past the DAC range.  tau starts at PI_TAU0
+//		and doubles each time the phase has held within PI_LOCK for 2 tau, up to PI_TAU1; past PI_SLIP
+//		it halves.  The DAC is updated every tau/8 periods (at most AVE_COUNT * DIV_MS).
+//
+//		The PI loop sees the time-marks through a clock-state estimator (kf_step()): phase, frequency
+//		(time-mark slope at the present DAC) and drift, predicted one period at a time and corrected
+//		by each mark.  The DAC changes go in through G, so the estimate follows the loop.  The gains
+//		are the steady-state (critically damped) ones of that 3-state filter:
+//
+//			phase += (1 - t^3) * err,  freq += 1.5 (1 - t)^2 (1 + t) * err,  drift += (1 - t)^3 * err
+//
+//		with 1 - t = 2^-kf_m, so they are shifts.  kf_m starts at KF_M0 and goes up by one every
+//		2^(kf_m + 1) marks to KF_M (memory about 2^KF_M periods).  In DR the DAC goes to the code that
+//		nulls the frequency estimate and follows the drift estimate each divider period.
+//
+//		Each TIM-TM2 mark is weighted by its accEst against the accEst floor (the lowest seen lately):
+//		the gains go down by the variance ratio, 2^-w for (accEst / floor)^2 ~ 2^w.  A mark over
+//		ACC_DEG x the floor is degraded and is not used at all (AQS and TRACK skip it as if the frame
+//		was lost).  A mark whose residual (time-mark against the estimate) is over ACC_K x accEst is an
+//		outlier and is skipped the same way, so it doesn't reach the DAC.  After ACC_NREJ in a row the
+//		phase really moved: the next one is taken and the estimator memory starts over.  The floor
+//		starts over on each AQS entry (acc_init()).
+//
 //--------------------------------------------------------------------------------------
 
 //-----------------------------------------------------------------------------
@@ -72,6 +185,7 @@
 #include "serial.h"
 #include "flash.h"
 #include "nvmem.h"
+#include "spi.h"
 
 //-----------------------------------------------------------------------------
 // Definitions
@@ -97,7 +211,7 @@
 
 // port assignments
 
-// PCB version 2 bbSPI defines
+// PCB version 2 SPI pins (on the crossbar as SPI0 SCK/MISO/MOSI)
 sbit SPCK       = P0^0;                         // (o) [spi]	SPI CLK
 sbit MISO       = P0^1;                         // (i) [spi]	SPI MISO
 sbit MOSI       = P0^2;                         // (o) [spi]	SPI MOSI
@@ -130,26 +244,122 @@ sbit ERROR      = P1^7;                         // (o) [gpio]	PEA register selec
 	volatile	U8	 	blinktimer2;
 				bit		blink_alive;		// blink enable for ALIVE LED
 				bit		thold;				// 16-bit timer hold flag
-	volatile	U8	 	ovrflo_count;		// pca overflow counter
-	
-	// bbSPI registers
-	volatile	U8		spdr_r;				// bbSPI MISO register
-	volatile	U8		spdr;				// bbSPI MOSI register
-	volatile	U8		spmask;				// bbSPI shift mask register
-
-	// PCA capture registers
-	volatile	U16		gcap;				// gps time pulse capture
-	volatile	U16		dcap;				// vco divider time pulse capture
+	volatile	U16	 	ovrflo_count;		// pca overflow counter (timestamp high word)
+
+	// PCA captures, overflow-corrected 32-bit timestamps (PCA counts)
+	volatile	U32		gts;				// gps time pulse capture
+	volatile	U32		dts;				// vco divider time pulse capture
+	volatile	S32		pca_ph;				// dts - gts of the nearest gps pulse (+ = divider late), set with TP_RDY
 	volatile	U8		cflag;				// capture flags
 
+	// VCO gain, starts from the divider period (tm2_per, set_period())
+	idata		U16		aqs_g;					// AQS DAC LSB per ns of slope, Q(AQS_SH) (measured by each jump)
+
+	// VCO mode state: AQS, TRACK and DR each start theirs over on entry and
+	// no mode reads another's, so they share the same idata
+	idata union {
+		struct {							// VCO_AQS jumps (aqs_est())
+			S32		s;						// slope before the last jump, ns per period
+			S32		j;						// the last jump, DAC LSB
+			U16		f;						// how far into its period the jump was, Q10
+			U8		n;						// jumps so far, 0 = none
+		} aqs;
+		struct {							// VCO_TRACK
+			S32		q;						// PI loop (pi_step()): DAC, Q12
+			S16		ph;						// phase since TRACK came up, ns (+ = VCO slow, PI_PHMAX max)
+			S32		ri;						// division remainders of the I and P steps
+			S16		rp;
+			U16		tau;					// loop time constant, periods
+			U16		ok;						// periods the phase has held within PI_LOCK
+			S32		e;						// estimator (kf_step()): phase estimate - last time-mark phase, ns Q16
+			U16		f;						// fraction of the phase change not yet passed on, ns Q16
+			U16		dac;					// DAC the estimate is at
+			U8		n;						// marks at this kf_m
+			U8		m;						// gains 2^-kf_m
+			U16		lph;					// lock quality (lq_step()): |phase| error (pi_ph), fading average, ns Q2
+			U16		ly;						// |frequency| error (kf_y), fading average, 1e-12 Q2
+		} trk;
+		struct {							// VCO_DR1 (kf_coast())
+			S32		q;						// DAC that nulls kf_y, Q12..
+			S32		a;						// ..and the drift since, ns per period Q20
+			U32		dts;					// last divider edge
+		} dr;
+	} vm;
+
+#define	aqs_s		vm.aqs.s
+#define	aqs_j		vm.aqs.j
+#define	aqs_f		vm.aqs.f
+#define	aqs_n		vm.aqs.n
+#define	pi_q		vm.trk.q
+#define	pi_ph		vm.trk.ph
+#define	pi_ri		vm.trk.ri
+#define	pi_rp		vm.trk.rp
+#define	pi_tau		vm.trk.tau
+#define	pi_ok		vm.trk.ok
+#define	kf_e		vm.trk.e
+#define	kf_f		vm.trk.f
+#define	kf_dac		vm.trk.dac
+#define	kf_n		vm.trk.n
+#define	kf_m		vm.trk.m
+#define	lq_ph		vm.trk.lph
+#define	lq_y		vm.trk.ly
+#define	kf_q		vm.dr.q
+#define	kf_a		vm.dr.a
+#define	kf_dts		vm.dr.dts
+
+	// clock-state estimator (kf_step()), per divider period, kept for DR
+	idata		S32		kf_y;					// frequency (time-mark slope at kf_dac), ns per period Q20
+	idata		S32		kf_d;					// drift, ns per period^2 Q28
+				bit		kf_ok;					// estimate is valid (TRACK ran)
+				bit		kf_rj;					// kf_step(): the mark was an outlier, not used
+
+	// TIM-TM2 accEst (acc_chk())
+	idata		U16		acc_ref;				// accEst floor, ns Q4 (0 = none yet)
+	idata		S16		acc_lim;				// residual limit of the last mark, ns
+	idata		U8		acc_w;					// its gain shift (variance ratio to the floor, 2^acc_w)
+	idata		U8		acc_nr;					// outliers in a row
+	idata		U16		acc_ndeg;				// marks not used: degraded accEst
+	idata		U16		acc_nrej;				// marks not used: residual over ACC_K x accEst
+
+#define	ACC_BAD		0xff				// acc_chk(): degraded
+#define	KF_MMAX		10					// kf_m + acc_w, max (3 x it is a shift of an S32)
+
+	// SPI0 jobs
+	idata		spi_job	dac_job;			// AD5761 write
+	idata		spi_job	ts_job;				// DS1722 r/w
+
 
 //-----------------------------------------------------------------------------
 // Local Prototypes
 //-----------------------------------------------------------------------------
 
-void send8(U8 sdata);
-U16 read_1722(U8 cdata);
+void read_1722(U8 cdata);
+U16 temp_1722(void);
 void rw_5761(U8 cdata, U16 ddata);
+U8 mark_n(U32 d);
+void set_period(U16 ms);
+void gps_rst(U8 trk);
+U8 ave_win(void);
+S16 aqs_nlim(void);
+U16 pi_tlim(U16 tau);
+S32 mark_d(U32 t, U32 to);
+S32 aqs_est(S32 d, U8 n);
+U16 pca_frac(void);
+void pi_init(U16 d);
+U16 pi_step(S32 d, U8 n);
+void kf_init(U16 d);
+S32 kf_step(S32 d, U8 n, U16 dac);
+U16 kf_hold(U16 d);
+U16 kf_coast(U16 d);
+U8 div_edge(void);
+void kf_ref(void);
+void acc_init(void);
+U8 acc_chk(U16 a);
+void lq_init(void);
+void lq_step(void);
+void lq_miss(void);
+void lq_led(void);
+void tec_step(U16 t);
 
 //******************************************************************************
 // main()
@@ -163,19 +373,17 @@ idata	volatile U8		vco_state;		// vco state machine reg
 //idata	volatile U8		dacupdate;		// tracking loop -- 1 = incremented last
 				bit		run;			// warm restart trigger
 				bit		vipl;			// vco IPL flag
-				bit		o;				// timark polarity temp flags
-				bit		oo;
+idata volatile	U8		tn;				// TRACK divider periods from tto to tt
+idata volatile	U8		ave_n;			// TRACK window, periods (doubles to ave_win())
 //idata volatile	U8		tempf;		// temp cflag
-	  volatile	U16		tt_temp;
-idata volatile	U16		ecount;			// temp
-idata volatile	U16		ii;				// temp
+idata volatile	U8		ecount;			// divider periods in avett (< ave_n + the MARK_MS gap)
 //idata volatile	U16		dacmax;			// dac min/max values
 //idata volatile	U16		dacmin;
 data volatile	U16		dac;			// dac value
-data volatile	U32		deldac;			// delta DAC value
 data volatile	U32		tt;				// time-mark 
-data volatile	U32		aa;				// time-mark accuracy
+data volatile	U16		aa;				// time-mark accuracy
 data volatile	U32		tto;			// previous cycle time-mark
+idata volatile	U32		ttms;			// its mark time (ms)
 data volatile	U32		avett;			// ave time-mark accum 
 
 
@@ -188,9 +396,7 @@ data volatile	U32		avett;			// ave time-mark accum
 		CS_TS = 0;
 		CS_DAC_N = 1;
 		RXD_MCU = 1;                        	// (i) [uart]	
-		SPCK = 0;								// (o) [spi]	SPI CLK
 		MISO = 1;								// (i) [spi]	SPI MISO
-		MOSI = 0;								// (o) [spi]	SPI MOSI
 		GPSTP = 1;								// (i) [pca]	
 //		TEC_FANON_N = 0;						// (o) [pca]	
 		PCA0CPM1  = FAN_OFF;
@@ -206,12 +412,16 @@ data volatile	U32		avett;			// ave time-mark accum
 		blinkpwm = BLINK_0;
 		init_flash();							// init FLASH registers
 		init_serial();
+		init_spi();
 		TEC_HOT_N  = 1;                         // init TEC H-bridge
 		TEC_COOL_N = 1;
 		EA = 1;
 		wait(10);
 		DIV_RST = 0;
 		cflag = 0;
+		acc_init();
+		acc_ndeg = 0;
+		acc_nrej = 0;
 		read_1722(1);							// init temperature sensor
 		rw_5761(DAC_WCNTL, DAC_CONFIG);			// init DAC
 		run = 1;								// enable run
@@ -219,8 +429,11 @@ data volatile	U32		avett;			// ave time-mark accum
 		gpstimer = 0;
 		thold = 0;
 		getm(&tt, &aa, 1);							// init get time-mark function
+		tm2_new = 0;
+		set_period(tm2_per);
 		vco_state = VCO_DR;						// init VCO state machine
-		ecount = AVE_COUNT;
+		ecount = 0;
+		ave_n = 1;
 		avett = 0;
 //		dacupdate = DAC_HOLD_COUNT;
 //		read_flast();
@@ -235,127 +448,118 @@ data volatile	U32		avett;			// ave time-mark accum
 		// main loop (run)
 		while(run){											// inner-loop runs the main application
 			PCON = 1;										// set idle mode (WAI)
+			if(tm2_new){									// divider period changed (TIM-TM2)
+				tm2_new = 0;
+				set_period(tm2_per);
+				if(vco_state == VCO_TRACK){					// TRACK starts over at PI_TAU0
+					pi_tau = pi_tlim(PI_TAU0);
+					pi_ok = 0;
+					pi_rp = 0;
+					pi_ri = 0;
+				}
+				avett = 0;
+				ecount = 0;
+				ave_n = 1;
+			}
 			switch(vco_state){
 			//
 			// ********** VCO acquisition loop ************ //
 			//
 			case VCO_AQS:
-				//  VCO AQS loop
+				//  VCO AQS loop: jump the DAC to the code the time-mark slope asks for
 				i = getm(&tt, &aa, 0);
+				if((i == 0) && (acc_chk(aa) == ACC_BAD)) i = 4;	// degraded: GPS is up, the mark isn't used
 				if(i == 0){
 					ALIVE = ~ALIVE;
-					if(vipl){
-						tto = tt;
+					tn = mark_n(tm2_ms - ttms);
+					if(vipl || !tn || (tn > AQS_TN)){		// first mark, or not chained to tto
 						vipl = 0;
-						deldac = 16384L;					// start at 1/2 DAC_FS
+						aqs_n = 0;
 					}else{
-						if(tt > tto){						// VCO too fast
-							dac -= (U16)deldac;
-						}else{								// VCO too slow
-							dac += (U16)deldac;
-						}
-						if(deldac > 1){
-							deldac >>= 1;
-						}else{
+						aqs_s = aqs_est(mark_d(tt, tto), tn);	// slope at this DAC setting (+ = VCO slow)
+						if((aqs_n >= AQS_MAX) || (((aqs_s < 0L) ? -aqs_s : aqs_s) <= aqs_nlim())){
 							vco_state = VCO_TRACK;
-							blinkpwm = BLINK_10;			// ERROR LED = 10%
+							ave_n = 1;
+							avett = 0;
+							ecount = 0;
+							pi_init(dac);
+							kf_init(dac);
+							lq_init();						// ERROR LED from here on is the lock quality
+						}else{
+							aqs_j = (aqs_s * (S32)aqs_g) >> AQS_SH;
+							aqs_j += (S32)dac;
+							if(aqs_j < 0L) aqs_j = 0L;
+							if(aqs_j > 0xffffL) aqs_j = 0xffffL;
+							aqs_j -= (S32)dac;
+							dac += (U16)aqs_j;
+							rw_5761(DAC_WRDAC, dac);		// set DAC output
+							aqs_f = pca_frac();
+							aqs_n++;
 						}
-						tto = tt;
-						rw_5761(DAC_WRDAC, dac);			// set DAC output
 					}
+					tto = tt;
+					ttms = tm2_ms;
 				}
 				if((i == 0) || (i == 4)){					// reset gps timeout if GPS is active and time valid
-					thold = 1;
-					gpstimer = GPS_TIMEOUT;
-					thold = 0;
+					gps_rst(0);
 				}
 				if(!gpstimer) vco_state = VCO_DR;			// GPS lost, switch to DR mode
 				break;
 			//
 			// ************ VCO tracking loop ************* //
 			//
-#define	KP	1264L
-#define	KPD	1000L
 			case VCO_TRACK:
 				i = getm(&tt, &aa, 0);						// update current time mark (tt)
+				if((i == 0) && (acc_chk(aa) == ACC_BAD)){
+					i = 4;									// degraded: as if the frame was lost
+					lq_miss();
+				}
 				if(i == 0){
 					if((tt > DEADLOCK_L) && (tt < DEADLOCK_U)){
 						i = 10;
 						DIV_RST = 1;						// re-sync the GPS and DIV time-pulses
 						while(DIV_RST);
-						thold = 1;							// start GPS time-out
-						gpstimer = GPS_TIMEOUT;
-						thold = 0;
+						gps_rst(1);							// start GPS time-out
 					}						
 				}
+				if(i == 0){
+					tn = mark_n(tm2_ms - ttms);
+					if(!tn){								// not chained to tto: start over from this mark
+						tto = tt;
+						kf_ref();
+					}
+				}
 				if(i == 0){									// tt is valid..
 //					if(!dacupdate){
-						if(tt != tto){
-							if(tt > MID_MARK) o = 1;
-							else o = 0;
-							if(tto > MID_MARK) oo = 1;
-							else oo = 0;
-							if(o == oo){						// values are in same hemisphere
-								if(tt > tto){					// VCO too slow
-									deldac = tt - tto;
-									tt_temp = (U16)deldac;
-									avett += deldac;
-//									if(deldac > aa) dac += ((U16)deldac * KP) / KPD;
-//									else dac += 1;
-								}else{							// VCO too fast
-									deldac = tto - tt;
-									tt_temp = (U16)deldac;
-									avett -= deldac;
-//									if(deldac > aa) dac -= ((U16)deldac * KP) / KPD;
-//									else dac -= 1;
-								}
-							}else{								// values have crossed hemispheres, must handle decimal rollover...
-								if(o == 0){						// VCO too slow
-									deldac = tt + (MAX_MARK - tto);
-									tt_temp = (U16)deldac;
-									avett += deldac;
-//									if(deldac > aa) dac += ((U16)deldac * KP) / KPD;
-//									else dac += 1;
-								}else{							// VCO too fast
-									deldac = tto + (MAX_MARK - tt);
-									tt_temp = (U16)deldac;
-									avett -= deldac;
-//									if(deldac > aa) dac -= ((U16)deldac * KP) / KPD;
-//									else dac -= 1;
-								}
+						if(tn){								// chained to tto: the change goes through the estimator
+							avett += (U32)kf_step(mark_d(tt, tto), tn, dac);	// (0 if kf_rj)
+							if(kf_rj){						// outlier: as if the mark was lost
+								i = 4;
+								lq_miss();
 							}
-							tto = tt;
-//							if(dac < dacmin) dacmin = dac;
-//							if(dac > dacmax) dacmax = dac;
-//							dac = ((dacmax - dacmin) >> 1) + dacmin;
-//							dacupdate = DAC_HOLD_COUNT;
 						}
 //					}else{
 //						dacupdate--;						// decrement hold count (dac is not updated
 //					}
-					if(ecount){
-						if(--ecount == 0){
-							ecount = AVE_COUNT;
-//							dacmin = dac;
-//							dacmax = dac;
-							ALIVE = ~ALIVE;
-							if(avett > 0x7fffffffL){		// if ave deltaT is negative...
-								avett = (~avett) + 1;
-								avett /= AVE_COUNT;
-								dac -= (U16)((avett * KP) / KPD);
-							}else{
-								avett /= AVE_COUNT;
-								dac += (U16)((avett * KP) / KPD);
-							}
-							avett = 0;
-							rw_5761(DAC_WRDAC, dac);		// set DAC output
-						}
+				}
+				if(i == 0){
+					tto = tt;
+					ttms = tm2_ms;
+					ecount += tn;
+					if(ecount >= ave_n){
+//						dacmin = dac;
+//						dacmax = dac;
+						ALIVE = ~ALIVE;
+						dac = pi_step((S32)avett, ecount);
+						avett = 0;
+						ecount = 0;
+						rw_5761(DAC_WRDAC, dac);			// set DAC output
+						lq_step();							// PPMFAIR, PPMGOOD, ERROR LED
+						ave_n = ave_win();					// next window, tau/8
 					}
 				}
 				if((i == 0) || (i == 4)){					// reset gps timeout if GPS is active and time valid
-					thold = 1;
-					gpstimer = GPS_TIMEOUT;
-					thold = 0;
+					gps_rst(1);
 				}
 				if(!gpstimer) vco_state = VCO_DR2;			// GPS lost, switch to DR mode
 				break;
@@ -365,18 +569,14 @@ data volatile	U32		avett;			// ave time-mark accum
 				if((cflag & GPS_TP) || (i == 0)){
 					DIV_RST = 1;							// re-sync the GPS and DIV time-pulses
 					while(DIV_RST);
-					thold = 1;								// start GPS time-out
-					gpstimer = GPS_TIMEOUT;
-					thold = 0;
-					cflag &= ~(GPSTPS | GPSFINE | GPS_TP | DIV_TP);
+					gps_rst(0);								// start GPS time-out
+					cflag &= ~(GPSTPS | GPSFINE | MASK_TP);
 					vco_state = VCO_TRACK2;					// set acquisition state
 					ALIVE = 0;
 //					tto = tt;
 				}
 				if((i == 0) || (i == 4)){					// reset gps timeout if GPS is active and time valid
-					thold = 1;
-					gpstimer = GPS_TIMEOUT;
-					thold = 0;
+					gps_rst(0);
 				}
 				if(!gpstimer) vco_state = VCO_DR2;			// GPS lost, switch to DR mode
 				break;
@@ -384,18 +584,18 @@ data volatile	U32		avett;			// ave time-mark accum
 			case VCO_TRACK2:
 				i = getm(&tt, &aa, 0);
 				if(i == 0){
-					thold = 1;								// start GPS time-out
-					gpstimer = GPS_TIMEOUT;
-					thold = 0;
-					cflag &= ~(GPSTPS | GPSFINE | GPS_TP | DIV_TP);
-					vco_state = VCO_TRACK;					// set acquisition state
-					blinkpwm = BLINK_10;					// set error 2 indication
+					gps_rst(0);								// start GPS time-out
+					cflag &= ~(GPSTPS | GPSFINE | MASK_TP);
+					vco_state = VCO_AQS;					// set acquisition state
+					blinkpwm = BLINK_50;					// set error 2 indication
+					vipl = 0;								// this mark starts the AQS
+					aqs_n = 0;
+					acc_init();								// new accEst floor
 					tto = tt;
+					ttms = tm2_ms;
 				}
 				if((i == 0) || (i == 4)){					// reset gps timeout if GPS is active and time valid
-					thold = 1;
-					gpstimer = GPS_TIMEOUT;
-					thold = 0;
+					gps_rst(0);
 				}
 				if(!gpstimer) vco_state = VCO_DR2;			// GPS lost, switch to DR mode
 				break;
@@ -409,26 +609,27 @@ data volatile	U32		avett;			// ave time-mark accum
 				if(dac == 0xffff){
 					dac = 34150; //33933; //34039; //33966;					// flash empty, use emperical value
 //					dac = 50000;
-//					deldac = 1;
 					blink_alive = 0;
 					vco_state = VCO_TRACK1;
-					thold = 1;								// fake the GPS for now (it will drop out of the tracking loop if absent)
-					gpstimer = GPS_TIMEOUT;
-					thold = 0;
+					gps_rst(0);								// fake the GPS for now (it will drop out of the tracking loop if absent)
 				}else{
-					deldac = 1;
 					blinkpwm = BLINK_100;					// set error 3 indication
 					ERROR = 1;
 					vco_state = VCO_DR1;					// init VCO state machine
 					blink_alive = 1;
 				}
+				kf_ok = 0;									// no estimate to hold
 //				dacmin = dac;								// init min/max
 //				dacmax = dac;
 				rw_5761(DAC_WRDAC, dac);					// set DAC output
 				wait(10);									// let the VCO settle a bit
 				break;
 
-			case VCO_DR2:									// DR entry (keep current DAC setting)
+			case VCO_DR2:									// DR entry (keep current DAC setting, or the estimate's)
+				if(kf_ok){
+					dac = kf_hold(dac);						// null the frequency estimate
+				}
+				cflag &= ~(MASK_TP | PPMFAIR | PPMGOOD);	// DR1 waits for a new pulse (the divider runs till then), no lock
 				blinkpwm = BLINK_100;						// set error 3 indication
 				ERROR = 1;
 				vco_state = VCO_DR1;						// init VCO state machine
@@ -436,15 +637,17 @@ data volatile	U32		avett;			// ave time-mark accum
 				break;
 
 			case VCO_DR1:
+				if(kf_ok && div_edge()){					// holdover: follow the drift estimate
+					dac = kf_coast(dac);
+				}
 				// look for GPS activity
 				if((cflag & GPS_TP) || (getm(&tt, &aa, 0) == 0)){
 					vipl = 1;								// re-IPL the VCO
+					acc_init();								// new accEst floor (the receiver may have changed)
 					DIV_RST = 1;							// re-sync the GPS and DIV time-pulses
 					while(DIV_RST);
-					thold = 1;								// start GPS time-out
-					gpstimer = GPS_TIMEOUT;
-					thold = 0;
-					cflag &= ~(GPSTPS | GPSFINE | GPS_TP | DIV_TP);
+					gps_rst(0);								// start GPS time-out
+					cflag &= ~(GPSTPS | GPSFINE | MASK_TP);
 					vco_state = VCO_AQS;					// set acquisition state
 					blinkpwm = BLINK_50;					// set error 2 indication
 					blink_alive = 0;
@@ -455,38 +658,10 @@ data volatile	U32		avett;			// ave time-mark accum
 			// TEC control loop
 			if(ttimer == 0){
 				ttimer = TEMP_TIMER;
-				ii = read_1722(0);
-				if(ii > TEMP_27){							// apply cool
-					TEC_HOT_N = 1;
-					TEC_COOL_N = 0;
-					thold = 1;
-					fantimer = FAN_ON_TIME;
-					thold = 0;
-//					TEC_FANON_N = 1;
-//					PCA0CPL1 = 0xff;
-//					PCA0CPH1 = 0xff;						// fan on (PWM = 0.0015%)
-					PCA0CPM1  = FAN_ON;						// fan on (PWM enabled at 100%)
-				}else{
-					if(ii < TEMP_23){						// apply heat
-						TEC_COOL_N = 1;
-						TEC_HOT_N = 0;
-						thold = 1;
-						fantimer = FAN_ON_TIME;
-						thold = 0;
-//						TEC_FANON_N = 1;
-//						PCA0CPL1 = 0xff;
-//						PCA0CPH1 = 0xff;					// fan on (PWM = 0.0015%)
-						PCA0CPM1  = FAN_ON;					// fan on (PWM enabled at 100%)
-					}else{
-						TEC_HOT_N = 1;						// TEC off
-						TEC_COOL_N = 1;
-						if(fantimer == 0){
-//							PCA0CPL1 = 0x0;
-//							PCA0CPH1 = 0x0;					// fan off (PWM = 100%)
-							PCA0CPM1  = FAN_OFF;			// fan on (PWM disabled)
-						}
-					}
-				}
+				if(!(ts_job.st & SPI_BUSY)) read_1722(0);	// start a temp read, it is picked up on a later pass
+			}
+			if(ts_job.st & SPI_DONE){
+				tec_step(temp_1722());
 			}
 		} // end while(run)
 	} // end outer while()
@@ -497,55 +672,587 @@ data volatile	U32		avett;			// ave time-mark accum
 // *********************************************
 
 //************************************************************************
-// send8() does a bit-bang SPI into a CD4094 to produce a port expansion
-//	output.  Uses T0 to clock data
+// read_1722() queues an SPI0 r/w of the DS1722 temp sensor IC
+//	CDATA == 0, start a temp read: ts_job.st is SPI_DONE when temp_1722() has
+//	the result.  Else send config data to sensor and wait for it (init only).
 //************************************************************************
-void send8(U8 sdata){
-	
-	spmask = 0x80;									// init mask
-	spdr = sdata;									// store to bbSPI data reg
-	TR0 = 1;
-	while(TR0);										// loop until xfr complete
+void read_1722(U8 cdata){
+
+	while(ts_job.st & SPI_BUSY);					// last r/w still queued
+	ts_job.cs = SPI_CS_TS;
+	if(cdata){
+		ts_job.len = 2;
+		ts_job.buf[0] = 0x80;						// set config register
+		ts_job.buf[1] = 0xee;
+		spi_post(&ts_job);
+		while(ts_job.st & SPI_BUSY);
+		ts_job.st = 0;
+	}else{
+		ts_job.len = 3;
+		ts_job.buf[0] = 0x01;						// read data register
+		ts_job.buf[1] = 0x00;
+		ts_job.buf[2] = 0x00;
+		spi_post(&ts_job);
+	}
 	return;
 }
 
 //************************************************************************
-// read_1722() does a bit-bang SPI into DS1722 temp sensor IC
-//	CDATA == 0, do temp read, else send config data to sensor
+// temp_1722() returns the temperature from a finished read_1722(0)
 //************************************************************************
-U16 read_1722(U8 cdata){
-	U16	i = 0;
+U16 temp_1722(void){
 
-	CS_TS = 1;
-	if(cdata){
-		send8(0x80);								// set config register
-		send8(0xee);
+	ts_job.st = 0;
+	return (U16)ts_job.buf[1] | (((U16)ts_job.buf[2]) << 8);
+}
+
+//************************************************************************
+// tec_step() is the TEC control loop on a DS1722 reading t: cool above
+//	TEMP_27, heat below TEMP_23, off in between.  The fan runs while the
+//	TEC does and FAN_ON_TIME after.
+//************************************************************************
+void tec_step(U16 t){
+
+	if(t > TEMP_27){							// apply cool
+		TEC_HOT_N = 1;
+		TEC_COOL_N = 0;
+		thold = 1;
+		fantimer = FAN_ON_TIME;
+		thold = 0;
+//		TEC_FANON_N = 1;
+//		PCA0CPL1 = 0xff;
+//		PCA0CPH1 = 0xff;						// fan on (PWM = 0.0015%)
+		PCA0CPM1  = FAN_ON;						// fan on (PWM enabled at 100%)
 	}else{
-		send8(0x01);								// read data register
-		send8(0x00);								// read data register
-		i = (U16)spdr_r;
-		send8(0x00);								// read data register
-		i |= ((U16)spdr_r) << 8;
+		if(t < TEMP_23){						// apply heat
+			TEC_COOL_N = 1;
+			TEC_HOT_N = 0;
+			thold = 1;
+			fantimer = FAN_ON_TIME;
+			thold = 0;
+//			TEC_FANON_N = 1;
+//			PCA0CPL1 = 0xff;
+//			PCA0CPH1 = 0xff;					// fan on (PWM = 0.0015%)
+			PCA0CPM1  = FAN_ON;					// fan on (PWM enabled at 100%)
+		}else{
+			TEC_HOT_N = 1;						// TEC off
+			TEC_COOL_N = 1;
+			if(fantimer == 0){
+//				PCA0CPL1 = 0x0;
+//				PCA0CPH1 = 0x0;					// fan off (PWM = 100%)
+				PCA0CPM1  = FAN_OFF;			// fan on (PWM disabled)
+			}
+		}
 	}
-	CS_TS = 0;
-	return i;
+	return;
 }
-
 //************************************************************************
-// rw_5761() does a bit-bang SPI r/w for the AD5761 DAC
+// rw_5761() queues an SPI0 write of the AD5761 DAC
 //	cdata is register addr (lower 4 bits are active)
 //	ddata is DAC data
+//	Only waits if the previous DAC frame is still queued (two frames, ~25us
+//	at most).
 //************************************************************************
 void rw_5761(U8 cdata, U16 ddata){
 
-	CS_DAC_N = 0;
-	send8(cdata);									// write config (addr) register
-	send8((U8)(ddata >> 8));						// write data
-	send8((U8)ddata);
-	CS_DAC_N = 1;
+	while(dac_job.st & SPI_BUSY);
+	dac_job.cs = SPI_CS_DAC;
+	dac_job.len = 3;
+	dac_job.buf[0] = cdata;							// write config (addr) register
+	dac_job.buf[1] = (U8)(ddata >> 8);				// write data
+	dac_job.buf[2] = (U8)ddata;
+	spi_post(&dac_job);
 	return;
 }
 //************************************************************************
+// mark_n() returns the divider periods in d (ms between two mark times),
+//	0 if d isn't a whole number of periods (+/- 2 ms) that fits in MARK_MS.
+//************************************************************************
+U8 mark_n(U32 d){
+	U32	n;
+
+	n = (d + (tm2_per / 2)) / tm2_per;
+	d -= n * tm2_per;
+	if((n > (MARK_MS / tm2_per)) || (n > 255L) || ((U32)(d + 2L) > 4L)) return 0;
+	return (U8)n;
+}
+//************************************************************************
+// set_period() takes a new divider period (ms): the VCO gain starts over
+//	from it.  The other values that go with the period (GPS time-out, TRACK
+//	window, AQS hand-over, PI tau limits) are worked out from tm2_per where
+//	they are used, not kept.
+//************************************************************************
+void set_period(U16 ms){
+	U32	t;
+
+	t = ((AQS_KP << AQS_SH) * DIV_MS) / (AQS_KPD * (U32)ms);	// 100/175 at DIV_MS, goes as 1/period
+	if(t > 0x3fffL) t = 0x3fffL;					// (aqs_est() may double it)
+	aqs_g = (U16)t;
+}
+//************************************************************************
+// gps_rst() restarts the GPS time-out: GPS_TIMEOUT is 2.5 DIV_MS periods,
+//	it goes with tm2_per but is no shorter than that.  TRACK (trk != 0)
+//	steps across missed marks for up to MARK_MS (mark_n()), so lost TIM-TM2
+//	frames only time it out past that.
+//************************************************************************
+void gps_rst(U8 trk){
+	U32	t;
+
+	t = ((U32)GPS_TIMEOUT * (U32)tm2_per) / DIV_MS;
+	if(t < GPS_TIMEOUT) t = GPS_TIMEOUT;
+	if(trk && (t < (MARK_MS / MS_PER_TIC))) t = MARK_MS / MS_PER_TIC;
+	if(t > 0xffffL) t = 0xffffL;
+	thold = 1;
+	gpstimer = (U16)t;
+	thold = 0;
+}
+//************************************************************************
+// ave_win() returns the next TRACK window (periods): tau/8, but no longer
+//	than AVE_COUNT * DIV_MS and at least 1.  A window plus a MARK_MS gap
+//	fits ecount (U8).
+//************************************************************************
+U8 ave_win(void){
+	U16	t;
+
+	t = (U16)(((AVE_COUNT * DIV_MS) + (tm2_per / 2)) / tm2_per);
+	if(t > (pi_tau >> 3)) t = pi_tau >> 3;
+	if(t > (255 - (MARK_MS / tm2_per))) t = (U16)(255 - (MARK_MS / tm2_per));
+	if(t == 0) t = 1;
+	return (U8)t;
+}
+//************************************************************************
+// aqs_nlim() returns the AQS hand-over slope (ns per period): AQS_LIM per
+//	DIV_MS, scaled to tm2_per, at least AQS_NMIN.
+//************************************************************************
+S16 aqs_nlim(void){
+	U32	t;
+
+	t = ((AQS_LIM * (U32)tm2_per) + (DIV_MS / 2L)) / DIV_MS;
+	if(t < AQS_NMIN) t = AQS_NMIN;
+	if(t > 0x7fffL) t = 0x7fffL;
+	return (S16)t;
+}
+//************************************************************************
+// pi_tlim() returns the PI time constant tau (s) in periods of tm2_per.
+//************************************************************************
+U16 pi_tlim(U16 tau){
+
+	if(((U32)tau * 1000L / tm2_per) > 0x7fffL) return 0x7fff;
+	tau = (U16)((U32)tau * 1000L / tm2_per);
+	if(tau < 8) tau = 8;
+	return tau;
+}
+//************************************************************************
+// mark_d() returns the time-mark change from to to t (ns), unwrapped
+//	across the 1 ms rollover (+ = VCO slow).
+//************************************************************************
+S32 mark_d(U32 t, U32 to){
+	S32	d;
+
+	d = (S32)t - (S32)to;
+	if(d > MID_MARK) d -= MAX_MARK;
+	if(d < -MID_MARK) d += MAX_MARK;
+	return d;
+}
+//************************************************************************
+// aqs_est() returns the time-mark slope (ns per period) at the present
+//	DAC setting from d, the change over n periods.  After a jump the first
+//	of those periods ran aqs_f/1024 on the old slope (aqs_s), that part is
+//	taken out.  What the jump changed the slope by is the VCO's gain: if
+//	that is well clear of the TIM-TM2 noise, aqs_g follows it (within 2x).
+//************************************************************************
+S32 aqs_est(S32 d, U8 n){
+	S32	s;
+	S32	g;
+
+	if(!aqs_n) return d / (S32)n;
+	s = ((d << 10) - ((S32)aqs_f * aqs_s)) / (((S32)n << 10) - (S32)aqs_f);
+	d = aqs_s - s;									// slope change the jump made
+	if(((d > ((S32)aqs_nlim() << 2)) && (aqs_j > 0)) || ((d < -((S32)aqs_nlim() << 2)) && (aqs_j < 0))){
+		g = (aqs_j << AQS_SH) / d;
+		if(g > ((S32)aqs_g << 1)) g = (S32)aqs_g << 1;
+		if(g < (S32)(aqs_g >> 1)) g = (S32)(aqs_g >> 1);
+		if(g > 0x3fffL) g = 0x3fffL;
+		if(g < 1L) g = 1L;
+		aqs_g = (U16)g;
+	}
+	return s;
+}
+//************************************************************************
+// pi_init() starts the TRACK PI loop at DAC code d, phase 0, tau PI_TAU0.
+//************************************************************************
+void pi_init(U16 d){
+
+	pi_q = (S32)d << 12;
+	pi_ph = 0;
+	pi_tau = pi_tlim(PI_TAU0);
+	pi_ok = 0;
+	pi_rp = 0;
+	pi_ri = 0;
+}
+//************************************************************************
+// pi_step() is one TRACK update: d is the phase change since the last one
+//	(ns), n the periods it took.  Returns the new DAC code.  The divisions
+//	carry their remainders, so the sub-LSB steps a long tau makes add up.
+//	The I step is divided by tau before n multiplies it, G * pi_ph * n
+//	doesn't fit 32 bits (a window can be more than 8 tau of 1 s periods).
+//	tau is then doubled or halved on how well the phase holds.
+//************************************************************************
+U16 pi_step(S32 d, U8 n){
+	S32	p;
+	S32	u;
+	S32	r;
+
+	if(d > PI_DMAX) d = PI_DMAX;
+	if(d < -PI_DMAX) d = -PI_DMAX;
+	p = (S32)pi_ph + d;
+	if(p > PI_PHMAX) p = PI_PHMAX;
+	if(p < -PI_PHMAX) p = -PI_PHMAX;
+	pi_ph = (S16)p;
+	// P: (KP/KPD) * 2 * G / tau per ns of change, I: G / tau^2 per ns period (Q12)
+	p = ((S32)aqs_g * 2L * KP) / KPD;
+	p = (p * d) + pi_rp;
+	pi_rp = p % (S32)pi_tau;
+	p /= (S32)pi_tau;
+	u = (S32)aqs_g * (S32)pi_ph;					// < 2^27
+	r = (u % (S32)pi_tau) * (S32)n;					// u * n = (u / tau) * n * tau + r..
+	u = (u / (S32)pi_tau) * (S32)n;
+	r += ((u % (S32)pi_tau) * (S32)pi_tau) + pi_ri;	// ..= (u / tau) * tau^2 + r (this u)
+	p += (u / (S32)pi_tau) + (r / ((S32)pi_tau * (S32)pi_tau));
+	pi_ri = r % ((S32)pi_tau * (S32)pi_tau);
+	pi_q += p;
+	if(pi_q < 0L){									// DAC range
+		pi_q = 0L;
+		pi_rp = 0;
+		pi_ri = 0;
+	}
+	if(pi_q > (0xffffL << 12)){
+		pi_q = 0xffffL << 12;
+		pi_rp = 0;
+		pi_ri = 0;
+	}
+	// gain schedule
+	if((pi_ph <= PI_LOCK) && (pi_ph >= -PI_LOCK)){
+		pi_ok += n;
+		if((pi_ok >= (pi_tau << 1)) && (pi_tau < pi_tlim(PI_TAU1))){
+			pi_tau <<= 1;
+			if(pi_tau > pi_tlim(PI_TAU1)) pi_tau = pi_tlim(PI_TAU1);
+			pi_ok = 0;
+			pi_rp = 0;
+			pi_ri = 0;
+		}
+	}else{
+		pi_ok = 0;
+		if(((pi_ph > PI_SLIP) || (pi_ph < -PI_SLIP)) && (pi_tau > pi_tlim(PI_TAU0))){
+			pi_tau >>= 1;
+			if(pi_tau < pi_tlim(PI_TAU0)) pi_tau = pi_tlim(PI_TAU0);
+			pi_rp = 0;
+			pi_ri = 0;
+		}
+	}
+	p = (pi_q + 0x800L) >> 12;
+	if(p > 0xffffL) p = 0xffffL;
+	return (U16)p;
+}
+//************************************************************************
+// kf_init() starts the clock-state estimator at DAC code d.  The frequency
+//	starts at 0 (the last AQS jump nulled the slope it measured), the drift
+//	estimate is kept.
+//************************************************************************
+void kf_init(U16 d){
+
+	kf_e = 0;
+	kf_y = 0;
+	kf_f = 0;
+	kf_dac = d;
+	kf_m = KF_M0;
+	kf_n = 0;
+	kf_ok = 1;
+	kf_rj = 0;
+}
+//************************************************************************
+// kf_step() runs the estimator over one time-mark: d is the time-mark
+//	change (ns) over n periods, dac the DAC code now (its change since the
+//	last mark moved the frequency by -1/G per LSB).  The mark's gain shift
+//	is acc_w.  Returns the estimated phase change (ns), the part below 1 ns
+//	is carried to the next one; 0 for an outlier (kf_rj).
+//
+//	A residual over acc_lim, or a change over KF_DMAX, is an outlier: kf_rj
+//	is set, the estimate is put back as it was (the prediction is undone)
+//	and the caller goes on as if the mark was lost (acc_nrej).  After
+//	ACC_NREJ in a row the mark is taken and the gains start over from
+//	KF_M0; a change over KF_DMAX (a divider re-sync) moves the reference
+//	to it.
+//
+//	On the CIP-51 that is about 3300 cycles (135 us) for a mark one period
+//	on with the DAC where it was, 10300 when the DAC moved (three long
+//	divides) and 18900 (0.77 ms) at most (n = 24, the DAC moved), well
+//	inside one MS_PER_TIC tic (on a hand translation of this function: d
+//	in R4-R7, n, dac and the locals in data, C51 long library calls).
+//************************************************************************
+S32 kf_step(S32 d, U8 n, U16 dac){
+	S32	p;
+	S32	q;
+	U8	i;
+
+	// control input
+	p = (S32)dac - (S32)kf_dac;
+	kf_dac = dac;
+	if(p > 0x7fffL) p = 0x7fffL;
+	if(p < -0x7fffL) p = -0x7fffL;
+	if(p){
+		p <<= 16;
+		q = p / (S32)aqs_g;							// Q4
+		if((q > 0x7fffL) || (q < -0x7fffL)){
+			kf_y = 0;								// no estimate for that
+		}else{
+			kf_y -= (q << 16) + (((p % (S32)aqs_g) << 15) / (S32)aqs_g << 1);
+		}
+	}
+	// predict
+	q = kf_e;
+	for(i=0; i<n; i++){
+		kf_e += (kf_y >> 4) + (kf_d >> 13);
+		kf_y += kf_d >> 8;
+	}
+	// correct
+	kf_rj = 0;
+	i = (d > KF_DMAX) || (d < -KF_DMAX);			// 1 = a step it can't carry
+	p = 0;
+	if(!i){
+		p = (d << 16) - kf_e;						// innovation, Q16
+		kf_e = 0;
+	}
+	if(i || ((p >> 16) > acc_lim) || ((p >> 16) < -acc_lim)){
+		if(acc_nr < ACC_NREJ){						// outlier: as if the mark was lost
+			acc_nr++;
+			acc_nrej++;
+			kf_e = q;
+			for(i=0; i<n; i++){						// (kf_d is as it was)
+				kf_y -= kf_d >> 8;
+			}
+			kf_rj = 1;
+			return 0;
+		}
+		kf_m = KF_M0;								// ACC_NREJ in a row, the phase really moved:
+		kf_n = 0;									//	the memory starts over..
+		if(i){
+			acc_nr = 0;								// ..and a step moves the reference
+			p = kf_e - q + kf_f;					// (the change is the prediction)
+			kf_e = 0;
+			q = p >> 16;
+			kf_f = p - (q << 16);
+			return q;
+		}
+	}
+	acc_nr = 0;
+	if(p > (KF_DMAX << 16)) p = KF_DMAX << 16;
+	if(p < -(KF_DMAX << 16)) p = -(KF_DMAX << 16);
+	i = kf_m + acc_w;								// accEst weight
+	if(i > KF_MMAX) i = KF_MMAX;
+	kf_e += ((3L * p) >> i) - ((3L * p) >> (i << 1)) + (p >> (3 * i)) - p;
+	kf_y += (((3L * p) >> (i << 1)) << 4) - (((3L * p) >> (3 * i + 1)) << 4);
+	if((3 * i) >= 12) kf_d += p >> (3 * i - 12);
+	else kf_d += p << (12 - 3 * i);
+	if(kf_d > KF_DRMAX) kf_d = KF_DRMAX;
+	if(kf_d < -KF_DRMAX) kf_d = -KF_DRMAX;
+	kf_n++;
+	if((kf_n >> (kf_m + 1)) && (kf_m < KF_M)){		// memory grows
+		kf_m++;
+		kf_n = 0;
+	}
+	// estimated phase change: d + the change in kf_e
+	p = (d << 16) + kf_e - q + kf_f;
+	q = p >> 16;
+	kf_f = p - (q << 16);
+	return q;
+}
+//************************************************************************
+// kf_ref() starts the estimate over at a mark tto moved to without it.
+//************************************************************************
+void kf_ref(void){
+
+	kf_e = 0;
+}
+//************************************************************************
+// kf_hold() is the DR entry: returns the DAC code that nulls the frequency
+//	estimate, and starts the drift from there.  kf_y is the frequency at
+//	kf_dac (the last mark), not at d (the code now, pi_step() may have moved
+//	it since).  kf_coast() writes it.
+//************************************************************************
+U16 kf_hold(U16 d){
+	S32	y;
+
+	y = kf_y >> 8;									// Q12
+	if(y > 0xffffL) y = 0xffffL;
+	if(y < -0xffffL) y = -0xffffL;
+	y = ((S32)kf_dac << 12) + ((y * (S32)aqs_g) >> 12);
+	kf_q = y;										// (over kf_dac in vm)
+	kf_a = 0;
+	EA = 0;
+	kf_dts = dts;
+	EA = 1;
+	return kf_coast(d);
+}
+//************************************************************************
+// kf_coast() returns the DR DAC code, kf_q plus the drift estimate added
+//	up per divider period (div_edge()), and writes it if it isn't d (the
+//	code now).
+//************************************************************************
+U16 kf_coast(U16 d){
+	S32	y;
+
+	kf_a += kf_d >> 8;
+	if(kf_a > (16L << 20)) kf_a = 16L << 20;
+	if(kf_a < -(16L << 20)) kf_a = -(16L << 20);
+	y = kf_q + (((kf_a >> 8) * (S32)aqs_g) >> 12) + 0x800L;
+	if(y < 0L) y = 0L;
+	y >>= 12;
+	if(y > 0xffffL) y = 0xffffL;
+	if((U16)y != d) rw_5761(DAC_WRDAC, (U16)y);	// set DAC output
+	return (U16)y;
+}
+//************************************************************************
+// div_edge() returns 1 once per divider edge (dts changed).
+//************************************************************************
+U8 div_edge(void){
+	U32	t;
+
+	EA = 0;
+	t = dts;
+	EA = 1;
+	if(t == kf_dts) return 0;
+	kf_dts = t;
+	return 1;
+}
+//************************************************************************
+// acc_init() starts the accEst floor over (AQS entry): the first mark sets
+//	it, and no outliers in a row.
+//************************************************************************
+void acc_init(void){
+
+	acc_ref = 0;
+	acc_nr = 0;
+}
+//************************************************************************
+// acc_chk() takes the accEst (ns) of a TIM-TM2 mark.  Returns its gain
+//	shift (acc_w, the variance ratio to the accEst floor rounded to a power
+//	of 2), or ACC_BAD if it is over ACC_DEG x the floor (acc_ndeg).  The
+//	floor drops to the lowest accEst and rises 2^-ACC_LEAK per mark, so a
+//	lasting change is taken in a few hundred marks.  Sets acc_lim.
+//************************************************************************
+U8 acc_chk(U16 a){
+	U32	s;
+	U32	t;
+
+	if(a > 2047) a = 2047;
+	if(a == 0) a = 1;
+	acc_lim = (S16)(ACC_K * (S32)a);				// (8188 max)
+	a <<= 4;
+	t = (U32)acc_ref + (acc_ref >> ACC_LEAK) + 1L;
+	if((acc_ref == 0) || ((U32)a < t)) t = a;
+	acc_ref = (U16)t;
+	if((U32)a > (ACC_DEG * (U32)acc_ref)){
+		acc_ndeg++;
+		return ACC_BAD;
+	}
+	s = (U32)a * (U32)a;
+	t = (U32)acc_ref * (U32)acc_ref;
+	acc_w = 0;
+	while(s > (t + (t >> 1))){						// (a / floor)^2 to 2^acc_w, rounded
+		t <<= 1;
+		acc_w++;
+	}
+	return acc_w;
+}
+//************************************************************************
+// lq_init() starts the lock quality at TRACK entry: both averages at 2x the
+//	fair limits (PPMFAIR and PPMGOOD clear) and the ERROR LED to match.
+//************************************************************************
+void lq_init(void){
+
+	lq_ph = LQ_PFAIR << 3;
+	lq_y = LQ_YFAIR << 3;
+	cflag &= ~(PPMFAIR | PPMGOOD);
+	lq_led();
+}
+//************************************************************************
+// lq_step() runs on each TRACK update: the loop phase error (|pi_ph|) and
+//	the frequency error (|kf_y|, as 1e-12) are averaged over 2^LQ_SH
+//	updates.  PPMFAIR and PPMGOOD are set with both averages under their
+//	limits and cleared with either one past 2x.
+//************************************************************************
+void lq_step(void){
+	S32	p;
+
+	p = pi_ph;
+	if(p < 0L) p = -p;
+	lq_ph = (U16)((S32)lq_ph + (((p << 2) - (S32)lq_ph) >> LQ_SH));
+	p = kf_y;
+	if(p < 0L) p = -p;
+	p >>= 10;										// ns per period, Q10
+	if(p > 0xffffL) p = 0xffffL;
+	p = (p * 977L) / (S32)tm2_per;					// 1e-12 (1000 x ns/s)
+	if(p > 16383L) p = 16383L;						// (Q2 in a U16)
+	lq_y = (U16)((S32)lq_y + (((p << 2) - (S32)lq_y) >> LQ_SH));
+	if((lq_ph < (LQ_PFAIR << 2)) && (lq_y < (LQ_YFAIR << 2))) cflag |= PPMFAIR;
+	if((lq_ph > (LQ_PFAIR << 3)) || (lq_y > (LQ_YFAIR << 3))) cflag &= ~PPMFAIR;
+	if((lq_ph < (LQ_PGOOD << 2)) && (lq_y < (LQ_YGOOD << 2))) cflag |= PPMGOOD;
+	if((lq_ph > (LQ_PGOOD << 3)) || (lq_y > (LQ_YGOOD << 3))) cflag &= ~PPMGOOD;
+	lq_led();
+}
+//************************************************************************
+// lq_miss() runs on each TRACK mark that is not used (degraded or an
+//	outlier): the phase average steps 2^-LQ_MSH toward 4x the fair limit, so
+//	PPMGOOD clears after a few misses in a row and PPMFAIR after a few
+//	dozen.  Only lq_step() sets them again.
+//************************************************************************
+void lq_miss(void){
+
+	lq_ph = (U16)((S32)lq_ph + (((LQ_PFAIR << 4) - (S32)lq_ph) >> LQ_MSH));
+	if(lq_ph > (LQ_PGOOD << 3)) cflag &= ~PPMGOOD;
+	if(lq_ph > (LQ_PFAIR << 3)) cflag &= ~PPMFAIR;
+	lq_led();
+}
+//************************************************************************
+// lq_led() sets the TRACK ERROR LED duty from the larger of the two errors:
+//	BLINK_10 per fair limit, up to just under BLINK_50 (that and BLINK_100
+//	are AQS and DR).  Steady off is PPMGOOD only.
+//************************************************************************
+void lq_led(void){
+	S32	e;
+	S32	f;
+
+	e = ((S32)lq_ph * BLINK_10) / (LQ_PFAIR << 2);
+	f = ((S32)lq_y * BLINK_10) / (LQ_YFAIR << 2);
+	if(f > e) e = f;
+	if(e > (BLINK_50 - 1)) e = BLINK_50 - 1;
+	if((e == 0) && !(cflag & PPMGOOD)) e = 1;
+	blinkpwm = (U8)e;
+}
+//************************************************************************
+// pca_frac() returns how far the PCA is past the last divider edge, in
+//	1/1024 of a period (1023 max).  PCA0L latches PCA0H, a pending overflow
+//	is placed as in pca_intr().
+//************************************************************************
+U16 pca_frac(void){
+	U16	c;
+	U16	h;
+	U32	t;
+
+	EA = 0;
+	c = (U16)PCA0L;
+	c |= (U16)PCA0H << 8;
+	h = ovrflo_count;
+	if(CF && !(c & 0x8000)) h++;
+	t = ((U32)h << 16) | (U32)c;
+	t -= dts;
+	EA = 1;
+	t /= ((PCA_MS * (U32)tm2_per) >> 10);
+	if(t > 1023L) t = 1023L;
+	return (U16)t;
+}
+//************************************************************************
 // wait() waits the U8 value then returns.
 //************************************************************************
 void wait(U8 wvalue){
@@ -559,21 +1266,34 @@ void wait(U8 wvalue){
 // pca_intr
 //-----------------------------------------------------------------------------
 //
-// <add description>
+// Time-stamps the GPS (CEX0) and divider (CEX2) time pulses.  The 16-bit
+//	capture register is extended with ovrflo_count to a 32-bit timestamp.  An
+//	overflow that is still pending (CF) when a capture is read belongs before
+//	that capture if the capture is in the low half of the count (the edge came
+//	just after the wrap), after it if in the high half.
+//
+// pca_ph is the divider edge minus the nearest GPS pulse (within half a
+//	second).  It is formed here at whichever edge of the pair comes second and
+//	flagged with TP_RDY.  A divider edge more than half a second after the last
+//	pulse waits (DIV_TP) for the next one.  GPS_TP flags every GPS pulse.
 //-----------------------------------------------------------------------------
 
 void pca_intr(void) interrupt 9 using 2{
-	U8	i;		// temps
-	U8	j;
+	U16	c;		// capture
+	U16	h;		// its overflow count
 
     // process GPS TimePulse
     if(CCF0 == 1){
 		DIV_RST = 0;								// enable divider
-        i = PCA0L;									// get capture time
-		j = PCA0H;
-		gcap = (((U16)i) << 8) + ((U16)j);
-		if(cflag & DIV_TP) cflag |= TP_RDY;
-		else cflag |= GPS_TP;
+		c = ((U16)PCA0CPH0 << 8) | (U16)PCA0CPL0;	// get capture time
+		h = ovrflo_count;
+		if(CF && !(c & 0x8000)) h++;				// overflow not counted yet
+		gts = ((U32)h << 16) | (U32)c;
+		if(cflag & DIV_TP){							// divider edge waiting for this pulse
+			pca_ph = (S32)(dts - gts);
+			cflag = (cflag & ~DIV_TP) | TP_RDY;
+		}
+		cflag |= GPS_TP | GPS_TS;
         CCF0 = 0;                       			// clr intr flag
     }
     // process fan PWM -- we have to process the ISR flag to get the PWM to work
@@ -583,11 +1303,19 @@ void pca_intr(void) interrupt 9 using 2{
     }
     // process divider-chain TimePulse
     if(CCF2 == 1){
-        i = PCA0L;									// get capture time
-		j = PCA0H;
-		dcap = (((U16)i) << 8) + ((U16)j);
-		if(cflag & GPS_TP) cflag |= TP_RDY;
-		else cflag |= DIV_TP;
+		c = ((U16)PCA0CPH2 << 8) | (U16)PCA0CPL2;	// get capture time
+		h = ovrflo_count;
+		if(CF && !(c & 0x8000)) h++;
+		dts = ((U32)h << 16) | (U32)c;
+		if(cflag & GPS_TS){
+			if((dts - gts) < PCA_HALF){				// last pulse is the nearest
+				pca_ph = (S32)(dts - gts);
+				cflag |= TP_RDY;
+			}else{
+				if((dts - gts) < 3L * PCA_HALF) cflag |= DIV_TP;	// next one is
+				else cflag &= ~GPS_TS;				// no pulse for 1.5 s
+			}
+		}
         CCF2 = 0;                      				// clr intr flag
     }
     // process PCA overflow
@@ -598,41 +1326,6 @@ void pca_intr(void) interrupt 9 using 2{
     return;
 }
 
-//-----------------------------------------------------------------------------
-// Timer0_ISR
-//-----------------------------------------------------------------------------
-//
-// Called when timer 0 overflows (NORM mode):
-//      drives bbSPI by shifting 8 bits out MOSI at the timer rate/2 (the timer
-//			sets the half clock period).
-//		If T0 enabled with spmask = 0, nothing happens except T0 is disabled when
-//			the interrupt happens.  This is used to time the strobe pulse (external
-//			code handles the strobe set/clear).
-//
-//-----------------------------------------------------------------------------
-
-void Timer0_ISR(void) interrupt 1
-{
-	if(!spmask){									// used to time strobe pulse
-		TR0 = 0;									// turn off T0 intrpt
-	}else{
-		if(SPCK){									// toggle clock & set MOSI or shift data, depending on edge
-			if(MISO == 1) spdr_r |= spmask;			// shift in data
-			else spdr_r &= ~spmask;
-			SPCK = 0;
-			spmask >>= 1;							// FE: shift data
-			if(!spmask) TR0 = 0;					// xfr done, disable intrpt
-		}else{
-			SPCK = 1;
-			if(spdr & spmask) MOSI = 1;				// RE: transfer sdata bit to output
-			else MOSI = 0;
-		}
-	}
-    TF0 = 0;                           				// Clear Timer0 intrpt flag
-
-	return;
-}
-
 //-----------------------------------------------------------------------------
 // Timer1_ISR
 //-----------------------------------------------------------------------------
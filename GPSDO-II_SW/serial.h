@@ -12,6 +12,14 @@
 
 /********************************************************************
  *  File scope declarations revision history:
+ *    10-17-26 jmh:  getm() takes data pointers, accEst as U16
+ *    10-17-26 jmh:  memory types on the externs; ACK-ACK/NAK, ack_*, tm2_tow, get_qerr() removed,
+ *					 tm2_new
+ *    10-17-26 jmh:  tm2_per
+ *    10-17-26 jmh:  tm2_ms
+ *    10-17-26 jmh:  get_qerr(), tm2_tow
+ *    10-17-26 jmh:  UBX message table ids and handler results
+ *    10-17-26 jmh:  rx frame drop counters
  *    08-23-20 jmh:  modified to support bluetooth interface
  *    09-09-12 jmh:  creation date
  *
@@ -21,6 +29,13 @@
 // extern defines
 #define	MAX_CTR 4			// max# response chrs to get
 
+// UBX messages framed by rxd_intr() (ubx_tab[] index)
+#define	UBX_TM2		0		// TIM-TM2 time mark
+#define	UBX_TP		1		// TIM-TP time pulse data
+#define	UBX_STAT	2		// NAV-STATUS
+#define	UBX_NMSG	3
+#define	UBX_EN_DEF	0x07	// ubx_en at init: all of them
+
 //------------------------------------------------------------------------------
 
 //------------------------------------------------------------------------------
@@ -41,7 +56,17 @@ char putch(const char c);
 //void cpy_str (char* src, char* dest);
 //char hiasc (U8 num);
 //char lowasc (U8 num);
-U8 getm (U32* rslt, U32* accuracy, U8 cmd);
+U8 getm (U32 data* rslt, U16 data* accuracy, U8 cmd);
+
+extern data U16 rxd_novr;				// UBX frames dropped: frame slot still full
+extern data U16 rxd_novf;				//   not the ubx_tab[] length
+extern data U16 rxd_nck;				//   bad checksum
+extern data U8 ubx_en;					// messages buffered (bit = 1 << UBX_xxx)
+extern idata U32 tm2_ms;				// mark time of the last good TIM-TM2 (ms, wnR * week + towMsR, mod 2^32)
+extern idata U16 tm2_per;				// divider period (ms) measured from TIM-TM2..
+extern bit tm2_new;						//   ..1 = it changed
+extern idata U8 nav_fix;				// NAV-STATUS gpsFix
+extern idata U8 nav_flags;				//   flags
 
 //------------------------------------------------------------------------------
 // global defines
@@ -49,4 +74,4 @@ U8 getm (U32* rslt, U32* accuracy, U8 cmd);
 
 #define NOTBUF 0
 #define TBUF 1
-#define	ESC	27
\ No newline at end of file
+#define	ESC	27
\ No newline at end of file
@@ -0,0 +1,193 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: ad5761.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   AD5761 16-bit DAC (VCO tuning voltage).  A frame is 24 bits,
+ *             [xxxx cccc dddddddd dddddddd], executed when SYNC (CS_DAC_N)
+ *             goes high.  Until the control register is written the output
+ *             is clamped to 0V, after that it starts at the power-up voltage
+ *             selected by PV.  Readback commands shift the register out on
+ *             SDO during the following frame.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+#include <string.h>
+#include "kernel.h"
+#include "board.h"
+#include "plant.h"
+#include "ad5761.h"
+
+//------------------------------------------------------------------------------
+// local defines (command and control bits, see init.h)
+//------------------------------------------------------------------------------
+
+#define	CMD_WRINP	0x1
+#define	CMD_UPDD	0x2
+#define	CMD_WRDAC	0x3
+#define	CMD_WCNTL	0x4
+#define	CMD_DRST	0x7
+#define	CMD_RINP	0xa
+#define	CMD_RDAC	0xb
+#define	CMD_RCNTL	0xc
+#define	CMD_FRST	0xf
+
+#define	CNTL_B2C	0x0080
+#define	CNTL_CV(c)	(((c) >> 9) & 0x03)
+#define	CNTL_PV(c)	(((c) >> 3) & 0x03)
+#define	CNTL_RA(c)	((c) & 0x07)
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+		ad5761_stats	ad5761_stat;
+
+static	uint32_t	sr;							// input shift register
+static	int			nbytes;
+static	uint32_t	sdo;						// readback frame
+static	uint16_t	cntl;						// control register
+static	int			cntl_valid;					// control register written
+static	uint16_t	inp;						// input register
+static	uint16_t	dacr;						// DAC register
+
+static const double range[8][2] = {				// RA2:0 -> { min, span }, V
+	{ -10.0, 20.0 }, { 0.0, 10.0 }, { -5.0, 10.0 }, { 0.0, 5.0 },
+	{ -2.5, 10.0 }, { -3.0, 6.0 }, { 0.0, 16.0 }, { 0.0, 20.0 },
+};
+
+static const uint16_t scale[4] = { 0x0000, 0x8000, 0xffff, 0x0000 };	// CV/PV: zero, mid, full
+
+//-----------------------------------------------------------------------------
+// ad5761_vout() returns the output voltage
+//-----------------------------------------------------------------------------
+double ad5761_vout(void){
+	uint16_t	c = dacr;
+
+	if(!cntl_valid) return 0.0;
+	if(cntl & CNTL_B2C) c ^= 0x8000;
+	return range[CNTL_RA(cntl)][0] + range[CNTL_RA(cntl)][1] * (double)c / 65536.0;
+}
+
+static void set_dac(uint16_t code){
+
+	dacr = code;
+	ad5761_stat.code = code;
+	ad5761_stat.updates++;
+	if(code < ad5761_stat.code_min) ad5761_stat.code_min = code;
+	if(code > ad5761_stat.code_max) ad5761_stat.code_max = code;
+	plant_vtune(ad5761_vout());
+}
+
+static void full_reset(void){
+
+	cntl = 0;
+	cntl_valid = 0;
+	inp = 0;
+	dacr = 0;
+	plant_vtune(0.0);
+}
+
+//-----------------------------------------------------------------------------
+// execute() runs a complete frame
+//-----------------------------------------------------------------------------
+static void execute(uint32_t w){
+	uint16_t	d = (uint16_t)w;
+
+	sdo = 0;
+	switch((w >> 16) & 0x0f){
+	case CMD_WRINP:
+		inp = d;
+		break;
+	case CMD_UPDD:
+		if(cntl_valid) set_dac(inp);
+		break;
+	case CMD_WRDAC:
+		inp = d;
+		if(cntl_valid) set_dac(inp);
+		break;
+	case CMD_WCNTL:
+		cntl = d & 0x07ff;
+		if(!cntl_valid){
+			cntl_valid = 1;
+			inp = scale[CNTL_PV(cntl)];
+			set_dac(inp);
+		}else{
+			plant_vtune(ad5761_vout());			// range change
+		}
+		break;
+	case CMD_DRST:
+		if(cntl_valid){
+			inp = scale[CNTL_CV(cntl)];
+			set_dac(inp);
+		}
+		break;
+	case CMD_RINP:
+		sdo = w & 0x0f0000L;
+		sdo |= inp;
+		break;
+	case CMD_RDAC:
+		sdo = w & 0x0f0000L;
+		sdo |= dacr;
+		break;
+	case CMD_RCNTL:
+		sdo = w & 0x0f0000L;
+		sdo |= cntl;
+		break;
+	case CMD_FRST:
+		full_reset();
+		break;
+	default:
+		break;
+	}
+	ad5761_stat.frames++;
+}
+
+//-----------------------------------------------------------------------------
+// SPI slave interface
+//-----------------------------------------------------------------------------
+static void dac_select(int on){
+
+	if(on){
+		sr = 0;
+		nbytes = 0;
+	}else{
+		if(nbytes < 3) ad5761_stat.short_frames++;
+		else execute(sr & 0xffffffL);			// last 24 bits clocked in
+	}
+}
+
+static uint8_t dac_tx(void){
+	int	n = nbytes;
+
+	if(n > 2) return 0;
+	return (uint8_t)(sdo >> (16 - 8 * n));
+}
+
+static void dac_rx(uint8_t c){
+
+	sr = (sr << 8) | c;
+	nbytes++;
+}
+
+spi_dev ad5761_dev = { "AD5761", dac_select, dac_tx, dac_rx };
+
+//-----------------------------------------------------------------------------
+// ad5761_init() is a power-on reset
+//-----------------------------------------------------------------------------
+void ad5761_init(void){
+
+	memset(&ad5761_stat, 0, sizeof(ad5761_stat));
+	ad5761_stat.code_min = 0xffff;
+	sdo = 0;
+	full_reset();
+}
@@ -0,0 +1,42 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: ad5761.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This is the header file for the AD5761 DAC model.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+#ifndef SIM_AD5761_H
+#define SIM_AD5761_H
+
+#include <stdint.h>
+
+struct ad5761_stats {
+	uint32_t	frames;						// 24-bit frames executed
+	uint32_t	short_frames;				// SYNC raised before 24 bits
+	uint32_t	updates;					// DAC register updates
+	uint16_t	code;						// DAC register
+	uint16_t	code_min;					// DAC register range since reset
+	uint16_t	code_max;
+};
+
+extern ad5761_stats ad5761_stat;
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+void ad5761_init(void);
+double ad5761_vout(void);
+
+#endif
@@ -0,0 +1,175 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: adev.cpp
+ *
+ *  Module:    Analysis
+ *
+ *  Summary:   Streaming overlapping ADEV/MDEV/TDEV (NIST SP 1065 forms).
+ *             Every sample closes one ADEV term and one MDEV term for each
+ *             averaging factor m = 1, 2, 4 ... mmax:
+ *
+ *               ADEV: x[k] - 2x[k-m] + x[k-2m]
+ *               MDEV: sum of m such differences = P[k+1] - 3P[k+1-m]
+ *                     + 3P[k+1-2m] - P[k+1-3m], P = prefix sum of x
+ *
+ *             so a ring of the last 3*mmax+1 samples and prefix sums is all
+ *             the history that is kept.  A term that touches a missing
+ *             sample is left out and the normalisation uses the terms
+ *             actually summed.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  adev_add_m() for a tau off the octave grid
+ *
+ *******************************************************************/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "adev.h"
+
+//-----------------------------------------------------------------------------
+// adev_init() allocates the ring for averaging factors up to mmax
+//-----------------------------------------------------------------------------
+int adev_init(adev_state* s, double tau0, uint32_t mmax){
+	uint64_t	n = 1;
+	uint32_t	m;
+
+	memset(s, 0, sizeof(*s));
+	if((tau0 <= 0.0) || (mmax < 1) || (mmax > (1u << 28))) return -1;
+	while(n < 3 * (uint64_t)mmax + 1) n <<= 1;
+	s->tau0 = tau0;
+	s->mmax = mmax;
+	s->mask = (uint32_t)(n - 1);
+	s->x = (double*)calloc(n, sizeof(double));
+	s->p = (long double*)calloc(n, sizeof(long double));
+	s->bad = (uint32_t*)calloc(n, sizeof(uint32_t));
+	if(!s->x || !s->p || !s->bad){
+		adev_free(s);
+		return -1;
+	}
+	for(m=1; (m <= mmax) && (s->ntau < ADEV_MAX_TAUS); m <<= 1){
+		s->tau[s->ntau++].m = m;
+	}
+	return 0;
+}
+
+void adev_free(adev_state* s){
+
+	free(s->x);
+	free(s->p);
+	free(s->bad);
+	s->x = 0;
+	s->p = 0;
+	s->bad = 0;
+}
+
+//-----------------------------------------------------------------------------
+// adev_add_m() adds averaging factor m (<= mmax) before the first sample,
+//	returns 0 if OK.  push() relies on tau[] being in increasing m.
+//-----------------------------------------------------------------------------
+int adev_add_m(adev_state* s, uint32_t m){
+	int		i;
+	int		j;
+
+	if(s->k || (m < 1) || (m > s->mmax)) return -1;
+	for(i=0; (i < s->ntau) && (s->tau[i].m < m); i++);
+	if((i < s->ntau) && (s->tau[i].m == m)) return 0;
+	if(s->ntau == ADEV_MAX_TAUS) return -1;
+	for(j=s->ntau; j>i; j--) s->tau[j] = s->tau[j - 1];
+	memset(&s->tau[i], 0, sizeof(s->tau[i]));
+	s->tau[i].m = m;
+	s->ntau++;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// push() stores sample k and P/bad at k+1, then closes the terms that end on
+//	sample k.  Ring slot i holds x[i], and P[i], bad[i] (sums over 0..i-1).
+//-----------------------------------------------------------------------------
+static void push(adev_state* s, double x, int valid){
+	uint64_t	k = s->k;
+	uint32_t	mk = s->mask;
+	adev_tau*	t;
+	long double	d;
+	int			i;
+
+	s->x[k & mk] = x;
+	s->psum += x;
+	if(!valid) s->nbad++;
+	s->p[(k + 1) & mk] = s->psum;
+	s->bad[(k + 1) & mk] = s->nbad;
+	for(i=0; i<s->ntau; i++){
+		t = &s->tau[i];
+		if(k < 2 * (uint64_t)t->m) break;		// m is increasing
+		// ADEV: samples k, k-m, k-2m
+		if(valid &&
+			(s->bad[(k - t->m + 1) & mk] == s->bad[(k - t->m) & mk]) &&
+			(s->bad[(k - 2 * t->m + 1) & mk] == s->bad[(k - 2 * t->m) & mk])){
+			d = (long double)x - 2.0L * s->x[(k - t->m) & mk] + s->x[(k - 2 * t->m) & mk];
+			t->s_a += d * d;
+			t->n_a++;
+		}
+		// MDEV: window k+1-3m .. k
+		if(k + 1 < 3 * (uint64_t)t->m) continue;
+		if(s->nbad != s->bad[(k + 1 - 3 * t->m) & mk]) continue;
+		d = s->psum - 3.0L * s->p[(k + 1 - t->m) & mk] + 3.0L * s->p[(k + 1 - 2 * t->m) & mk]
+			- s->p[(k + 1 - 3 * t->m) & mk];
+		t->s_m += d * d;
+		t->n_m++;
+	}
+	s->k++;
+}
+
+//-----------------------------------------------------------------------------
+// adev_add() takes the next phase sample (s).  The first sample is removed
+//	from all of them to keep the prefix sums small.
+//-----------------------------------------------------------------------------
+void adev_add(adev_state* s, double x){
+
+	if(!s->have_x0){
+		s->have_x0 = 1;
+		s->x0 = x;
+	}
+	push(s, x - s->x0, 1);
+}
+
+void adev_gap(adev_state* s){
+
+	push(s, 0.0, 0);
+}
+
+//-----------------------------------------------------------------------------
+// adev_result() fills pt[] (ADEV_MAX_TAUS entries) with the taus that have at
+//	least one ADEV term, returns the count
+//-----------------------------------------------------------------------------
+int adev_result(const adev_state* s, adev_point* pt){
+	const adev_tau*	t;
+	long double		tau;
+	long double		m;
+	int				i;
+	int				n = 0;
+
+	for(i=0; i<s->ntau; i++){
+		t = &s->tau[i];
+		if(!t->n_a) continue;
+		m = t->m;
+		tau = m * s->tau0;
+		pt[n].tau = (double)tau;
+		pt[n].n = t->n_a;
+		pt[n].adev = (double)sqrtl(t->s_a / (2.0L * tau * tau * t->n_a));
+		pt[n].mdev = NAN;
+		pt[n].tdev = NAN;
+		if(t->n_m){
+			pt[n].mdev = (double)sqrtl(t->s_m / (2.0L * m * m * tau * tau * t->n_m));
+			pt[n].tdev = (double)(tau / sqrtl(3.0L)) * pt[n].mdev;
+		}
+		n++;
+	}
+	return n;
+}
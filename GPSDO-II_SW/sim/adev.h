@@ -0,0 +1,77 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: adev.h
+ *
+ *  Module:    Analysis
+ *
+ *  Summary:   This is the header file for the streaming stability engine:
+ *             overlapping Allan, modified Allan and time deviation at
+ *             octave-spaced averaging factors, from phase samples, in one
+ *             pass with memory set by the largest averaging factor only.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  adev_add_m()
+ *
+ *******************************************************************/
+
+#ifndef SIM_ADEV_H
+#define SIM_ADEV_H
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// extern defines
+//------------------------------------------------------------------------------
+
+#define	ADEV_MAX_TAUS	32
+
+struct adev_tau {
+	uint32_t	m;							// averaging factor (tau = m * tau0)
+	uint64_t	n_a;						// ADEV terms
+	long double	s_a;						// sum of squared second differences
+	uint64_t	n_m;						// MDEV terms
+	long double	s_m;
+};
+
+struct adev_state {
+	double		tau0;						// sample interval, s
+	uint32_t	mmax;						// largest averaging factor
+	uint32_t	mask;						// ring size - 1 (power of 2 >= 3*mmax+1)
+	uint64_t	k;							// samples seen, gaps included
+	int			have_x0;
+	double		x0;							// first valid sample (removed from all)
+	double*		x;							// ring: samples
+	long double* p;							// ring: prefix sums, p[k] = x[0] + ... + x[k-1]
+	uint32_t*	bad;						// ring: prefix count of missing samples
+	long double	psum;
+	uint32_t	nbad;
+	int			ntau;
+	adev_tau	tau[ADEV_MAX_TAUS];
+};
+
+struct adev_point {
+	double		tau;						// s
+	uint64_t	n;							// ADEV terms
+	double		adev;						// overlapping Allan deviation
+	double		mdev;						// modified Allan deviation
+	double		tdev;						// time deviation, s
+};
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+int adev_init(adev_state* s, double tau0, uint32_t mmax);	// 0 = OK
+int adev_add_m(adev_state* s, uint32_t m);	// extra averaging factor, 0 = OK
+void adev_add(adev_state* s, double x);		// next phase sample, s
+void adev_gap(adev_state* s);				// next sample is missing
+int adev_result(const adev_state* s, adev_point* pt);	// returns points filled
+void adev_free(adev_state* s);
+
+#endif
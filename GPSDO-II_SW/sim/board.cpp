@@ -0,0 +1,130 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: board.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   GPSDO-II board model.  P0.0-P0.2 carry the SPI bus to the
+ *             AD5761 DAC (CS_DAC_N, active low) and the DS1722 temperature
+ *             sensor (CS_TS, active high), driven by SPI0 (board_spi()) or,
+ *             in GPSDO2.hex, bit-banged on the port pins.  P1 also drives
+ *             the TEC H-bridge, the divider reset and the two LEDs.
+ *
+ *             The slaves present MISO on the rising SPCK edge and sample
+ *             MOSI on the falling edge; the bit-bang Timer0_ISR changes MOSI
+ *             after it raises SPCK, so the bus needs no finer timing than this.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  board_spi() for SPI0
+ *
+ *******************************************************************/
+
+#include "c8051F520.h"
+#include "kernel.h"
+#include "board.h"
+#include "plant.h"
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+static	spi_dev*	sel;					// selected slave (NULL = none)
+static	uint8_t		sh_out;					// MISO shift register
+static	uint8_t		sh_in;					// MOSI shift register
+static	int			nbit;					// bits shifted in the current byte
+static	uint8_t		miso;					// MISO pin level
+
+//-----------------------------------------------------------------------------
+// board_init()
+//-----------------------------------------------------------------------------
+void board_init(void){
+
+	sel = 0;
+	nbit = 0;
+	miso = 1;
+}
+
+//-----------------------------------------------------------------------------
+// board_pins() returns the pin levels seen by a port read.  Inputs that are
+//	not driven by the board read back as pulled up.
+//-----------------------------------------------------------------------------
+uint8_t board_pins(int port){
+
+	if(port == 0) return miso ? 0xff : (uint8_t)~PIN_MISO;
+	return 0xff;
+}
+
+//-----------------------------------------------------------------------------
+// spi_select() follows the chip selects on P1
+//-----------------------------------------------------------------------------
+static void spi_select(uint8_t p1){
+	spi_dev*	dev = 0;
+
+	if(!(p1 & PIN_CS_DAC_N)) dev = &ad5761_dev;
+	if(p1 & PIN_CS_TS){
+		if(dev) sim_fatal("SPI chip selects both active");
+		dev = &ds1722_dev;
+	}
+	if(dev == sel) return;
+	if(sel) sel->select(0);
+	sel = dev;
+	nbit = 0;
+	miso = 1;
+	if(sel) sel->select(1);
+}
+
+//-----------------------------------------------------------------------------
+// board_port() is called on every write to P0 or P1
+//-----------------------------------------------------------------------------
+void board_port(int port, uint8_t old, uint8_t val){
+	uint8_t	chg = old ^ val;
+
+	if(port == 0){
+		if(!(chg & PIN_SPCK) || !sel) return;
+		if(val & PIN_SPCK){							// rising: present MISO
+			if(nbit == 0) sh_out = sel->tx();
+			miso = (sh_out >> 7) & 1;
+			sh_out <<= 1;
+		}else{										// falling: sample MOSI
+			sh_in = (uint8_t)((sh_in << 1) | ((val & PIN_MOSI) ? 1 : 0));
+			if(++nbit == 8){
+				nbit = 0;
+				sel->rx(sh_in);
+			}
+		}
+		return;
+	}
+	if(chg & (PIN_CS_DAC_N | PIN_CS_TS)) spi_select(val);
+	if(chg & PIN_DIV_RST) plant_div_reset((val & PIN_DIV_RST) != 0);
+}
+
+//-----------------------------------------------------------------------------
+// board_spi() exchanges one byte with the selected slave (SPI0), returns the
+//	MISO byte.  Nothing selected reads as the MISO pull-up.
+//-----------------------------------------------------------------------------
+uint8_t board_spi(uint8_t mosi){
+	uint8_t	c;
+
+	if(!sel) return 0xff;
+	c = sel->tx();
+	sel->rx(mosi);
+	return c;
+}
+
+//-----------------------------------------------------------------------------
+// board_tec() returns the H-bridge drive (both low is not a valid state)
+//-----------------------------------------------------------------------------
+int board_tec(void){
+	uint8_t	p1 = sfr_latch(P1.addr);
+
+	if(!(p1 & PIN_TEC_HOT_N) && !(p1 & PIN_TEC_COOL_N)) sim_fatal("TEC H-bridge shoot-through");
+	if(!(p1 & PIN_TEC_HOT_N)) return 1;
+	if(!(p1 & PIN_TEC_COOL_N)) return -1;
+	return 0;
+}
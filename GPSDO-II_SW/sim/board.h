@@ -0,0 +1,68 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: board.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This is the header file for the GPSDO-II board model: the
+ *             port pins of the F520 and the parts wired to them.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  board_spi()
+ *
+ *******************************************************************/
+
+#ifndef SIM_BOARD_H
+#define SIM_BOARD_H
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// extern defines
+//------------------------------------------------------------------------------
+
+// port bits (see main.c)
+#define	PIN_SPCK		0x01				// P0
+#define	PIN_MISO		0x02
+#define	PIN_MOSI		0x04
+#define	PIN_CS_DAC_N	0x01				// P1
+#define	PIN_CS_TS		0x02
+#define	PIN_TEC_HOT_N	0x08
+#define	PIN_TEC_COOL_N	0x10
+#define	PIN_DIV_RST		0x20
+#define	PIN_ALIVE		0x40
+#define	PIN_ERROR		0x80
+
+//------------------------------------------------------------------------------
+// SPI slave interface.  The bus model shifts whole bytes: tx() is asked for
+//	the next MISO byte at the first clock of a byte, rx() gets the MOSI byte
+//	after its last clock.
+//------------------------------------------------------------------------------
+
+struct spi_dev {
+	const char*	name;
+	void	(*select)(int on);
+	uint8_t	(*tx)(void);
+	void	(*rx)(uint8_t c);
+};
+
+extern spi_dev ad5761_dev;
+extern spi_dev ds1722_dev;
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+void board_init(void);
+uint8_t board_pins(int port);
+void board_port(int port, uint8_t old, uint8_t val);
+uint8_t board_spi(uint8_t mosi);			// one SPI0 byte, returns MISO
+int board_tec(void);						// +1 = heat, -1 = cool, 0 = off
+
+#endif
@@ -0,0 +1,878 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: cip51.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   Cycle-counting CIP-51 instruction-set simulator.  Executes
+ *             the shipped Intel HEX image against the same SFR register
+ *             file, peripheral and board models as gpsdo_sim, so the
+ *             timers, PCA captures, UART bytes and SPI devices behave the
+ *             same way; only the CPU is different.
+ *
+ *             Instruction times are the CIP-51 clock counts from the
+ *             C8051F52x data sheet (flash read time 1 clock, SYSCLK
+ *             <= 25 MHz); a taken branch costs one more clock.  Interrupts
+ *             are sampled at instruction boundaries: a request needs one
+ *             clock to be seen and vectoring is a 4 clock LCALL.  After
+ *             RETI, or a write to IE/IP/EIE1/EIP1, one more instruction runs
+ *             before the next vector.  The two priority levels nest.
+ *
+ *             The stats are the cost of the real binary: request-to-ISR
+ *             latency and ISR length per vector, main loop cycles between
+ *             IDLE entries (main() sets PCON.IDLE at the top of each pass)
+ *             and the fraction of time the CPU is not idle.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "c8051F520.h"
+#include "kernel.h"
+#include "mcu.h"
+#include "cseg.h"
+#include "cip51.h"
+
+//------------------------------------------------------------------------------
+// local defines
+//------------------------------------------------------------------------------
+
+#define	PSW_CY		0x80
+#define	PSW_AC		0x40
+#define	PSW_OV		0x04
+#define	PSW_P		0x01
+
+#define	REG_A		sfr_reg[ACC.addr]
+#define	REG_B		sfr_reg[B.addr]
+#define	REG_PSW		sfr_reg[PSW.addr]
+#define	REG_SP		sfr_reg[SP.addr]
+#define	CARRY		((REG_PSW >> 7) & 1)
+#define	RN(n)		iram[(REG_PSW & 0x18) + (n)]
+
+#define	PSCTL_PSWE	0x01
+
+// clocks per opcode, branch not taken (C8051F52x data sheet, CIP-51
+//	instruction set summary)
+static const uint8_t op_clk[256] = {
+//	x0 x1 x2 x3 x4 x5 x6 x7 x8 x9 xA xB xC xD xE xF
+	1, 3, 4, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1,		// 0x
+	3, 3, 4, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1,		// 1x
+	3, 3, 5, 1, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1,		// 2x
+	3, 3, 5, 1, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1,		// 3x
+	2, 3, 2, 3, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1,		// 4x
+	2, 3, 2, 3, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1,		// 5x
+	2, 3, 2, 3, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1,		// 6x
+	2, 3, 2, 3, 2, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,		// 7x
+	3, 3, 2, 3, 8, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,		// 8x
+	3, 3, 2, 3, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1,		// 9x
+	2, 3, 2, 1, 4, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,		// Ax
+	2, 3, 2, 1, 3, 4, 4, 4, 3, 3, 3, 3, 3, 3, 3, 3,		// Bx
+	2, 3, 2, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1,		// Cx
+	2, 3, 2, 1, 1, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,		// Dx
+	3, 3, 3, 3, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1,		// Ex
+	3, 3, 3, 3, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1,		// Fx
+};
+
+#define	VECTOR_CLK	4							// hardware LCALL
+#define	MAX_NEST	2							// low + high priority
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+		cip51_stats	cip51_stat;
+
+static	uint8_t		code[CIP51_CODE];
+static	uint8_t		iram[256];
+static	uint8_t		xram[CIP51_XRAM];
+static	uint16_t	pc;
+static	sim_time_t	cyc;						// CPU time (cycles), ahead of sim_now
+static	int			idle;						// PCON.IDLE
+static	int			block;						// hold off vectoring for one instruction
+static	int			irq_dirty;					// re-evaluate pending requests
+static	unsigned	pend;						// requests flagged and enabled (vector index mask)
+static	unsigned	pend_hi;
+static	sim_time_t	t_req[16];					// time each pending request was raised
+
+struct isr_frame {
+	int			v;							// vector table index
+	int			hi;							// priority level
+	sim_time_t	start;						// vectoring started
+};
+
+static	isr_frame	nest[MAX_NEST];
+static	int			depth;
+static	uint64_t	pass_cyc;					// main context cycles this pass
+static	sim_time_t	wake;						// end of the last IDLE
+
+//-----------------------------------------------------------------------------
+// cseg_ptr() for mcu.cpp's flash controller: the ISS code image stands in for
+//	the native build's cseg.cpp.  PSWE-enabled MOVX writes store here directly.
+//-----------------------------------------------------------------------------
+uint8_t* cseg_ptr(uint32_t addr){
+
+	if(addr >= CIP51_CODE) sim_fatal("code address not mapped");
+	return &code[addr];
+}
+
+//-----------------------------------------------------------------------------
+// cip51_load() reads an Intel HEX file into the (erased) code space
+//-----------------------------------------------------------------------------
+static int hex_byte(const char* p){
+	int	v = 0;
+	int	i;
+
+	for(i=0; i<2; i++){
+		v <<= 4;
+		if((p[i] >= '0') && (p[i] <= '9')) v += p[i] - '0';
+		else if((p[i] >= 'A') && (p[i] <= 'F')) v += p[i] - 'A' + 10;
+		else if((p[i] >= 'a') && (p[i] <= 'f')) v += p[i] - 'a' + 10;
+		else return -1;
+	}
+	return v;
+}
+
+int cip51_load(const char* path){
+	FILE*	fp = fopen(path, "r");
+	char	line[600];
+	int		b[256 + 5];
+	int		n;
+	int		i;
+	int		sum;
+	int		addr;
+	int		rtn = HEX_OK;
+
+	if(!fp) return HEX_OPEN;
+	memset(code, 0xff, sizeof(code));
+	while((rtn == HEX_OK) && fgets(line, sizeof(line), fp)){
+		if(line[0] != ':') continue;
+		n = hex_byte(line + 1);
+		if((n < 0) || (strlen(line) < (size_t)(11 + 2 * n))){
+			rtn = HEX_FORMAT;
+			break;
+		}
+		sum = 0;
+		for(i=0; i<n+5; i++){
+			b[i] = hex_byte(line + 1 + 2 * i);
+			if(b[i] < 0) break;
+			sum += b[i];
+		}
+		if((i < n + 5) || (sum & 0xff)){
+			rtn = HEX_FORMAT;
+			break;
+		}
+		addr = (b[1] << 8) | b[2];
+		switch(b[3]){
+		case 0x00:								// data
+			if(addr + n > CIP51_CODE){
+				rtn = HEX_RANGE;
+				break;
+			}
+			for(i=0; i<n; i++) code[addr + i] = (uint8_t)b[4 + i];
+			break;
+		case 0x01:								// end of file
+			fclose(fp);
+			return HEX_OK;
+		case 0x02:								// segment/linear base: only 0 fits
+		case 0x04:
+			if(b[4] || b[5]) rtn = HEX_RANGE;
+			break;
+		default:
+			break;
+		}
+	}
+	fclose(fp);
+	return rtn;
+}
+
+//-----------------------------------------------------------------------------
+// cip51_reset() is a power-on reset of the core.  The SFRs are reset by
+//	sfr_reset(); idata is random on the target and cleared by STARTUP.A51.
+//-----------------------------------------------------------------------------
+void cip51_reset(void){
+
+	memset(iram, 0, sizeof(iram));
+	memset(xram, 0, sizeof(xram));
+	memset(&cip51_stat, 0, sizeof(cip51_stat));
+	pc = 0;
+	cyc = 0;
+	idle = 0;
+	block = 0;
+	irq_dirty = 1;
+	pend = 0;
+	pend_hi = 0;
+	depth = 0;
+	pass_cyc = 0;
+	wake = 0;
+	cip51_stat.sp_max = REG_SP;
+}
+
+//-----------------------------------------------------------------------------
+// memory access.  Direct addresses 0x80-0xff are SFRs.  Read-modify-write
+//	instructions read the port latch, everything else reads the pins.
+//-----------------------------------------------------------------------------
+static inline uint8_t fetch(void){
+
+	return code[pc++ & (CIP51_CODE - 1)];
+}
+
+static uint8_t rd_sfr(uint8_t a){
+	uint8_t	v;
+
+	if(a == PSW.addr){							// P follows the accumulator
+		v = REG_PSW & ~PSW_P;
+		return v | (__builtin_parity(REG_A) ? PSW_P : 0);
+	}
+	return sfr_read(a);
+}
+
+static void wr_sfr(uint8_t a, uint8_t v){
+
+	if(a == PCON.addr){
+		if((v & 0x01) && !depth && !cip51_stat.boot){
+			cip51_stat.boot = cyc;				// reset to the first IDLE
+			pass_cyc = 0;
+		}else if((v & 0x01) && !depth){			// main loop pass ends here
+			cip51_stat.passes++;
+			cip51_stat.pass_sum += pass_cyc;
+			if(pass_cyc > cip51_stat.pass_max) cip51_stat.pass_max = (uint32_t)pass_cyc;
+			if(cyc - wake > cip51_stat.pass_span_max) cip51_stat.pass_span_max = (uint32_t)(cyc - wake);
+			pass_cyc = 0;
+		}
+		if(v & 0x01) idle = 1;
+	}
+	if((a == IE.addr) || (a == IP.addr) || (a == EIE1.addr) || (a == EIP1.addr)) block = 1;
+	sfr_write(a, v);
+	irq_dirty = 1;
+}
+
+static inline uint8_t rd_dir(uint8_t a){
+
+	return (a < 0x80) ? iram[a] : rd_sfr(a);
+}
+
+static inline uint8_t rd_rmw(uint8_t a){
+
+	if(a < 0x80) return iram[a];
+	if((a == P0.addr) || (a == P1.addr)) return sfr_latch(a);
+	return rd_sfr(a);
+}
+
+static inline void wr_dir(uint8_t a, uint8_t v){
+
+	if(a < 0x80) iram[a] = v;
+	else wr_sfr(a, v);
+}
+
+static inline int rd_bit(uint8_t b){
+
+	if(b < 0x80) return (iram[0x20 + (b >> 3)] >> (b & 7)) & 1;
+	return (rd_sfr(b & 0xf8) >> (b & 7)) & 1;
+}
+
+static inline int rd_bit_rmw(uint8_t b){
+
+	if(b < 0x80) return (iram[0x20 + (b >> 3)] >> (b & 7)) & 1;
+	return (sfr_latch(b & 0xf8) >> (b & 7)) & 1;
+}
+
+static void wr_bit(uint8_t b, int v){
+	uint8_t	m = (uint8_t)(1 << (b & 7));
+	uint8_t	a;
+
+	if(b < 0x80){
+		a = 0x20 + (b >> 3);
+		iram[a] = v ? (iram[a] | m) : (iram[a] & ~m);
+		return;
+	}
+	a = b & 0xf8;								// bit-addressable SFRs: latch = register
+	wr_sfr(a, v ? (sfr_latch(a) | m) : (sfr_latch(a) & ~m));
+}
+
+static inline void set_cy(int c){
+
+	REG_PSW = c ? (REG_PSW | PSW_CY) : (REG_PSW & ~PSW_CY);
+}
+
+static inline void push(uint8_t v){
+
+	iram[++REG_SP] = v;
+	if(REG_SP > cip51_stat.sp_max) cip51_stat.sp_max = REG_SP;
+}
+
+static inline uint8_t pop(void){
+
+	return iram[REG_SP--];
+}
+
+static inline uint16_t dptr(void){
+
+	return (uint16_t)((sfr_reg[DPH.addr] << 8) | sfr_reg[DPL.addr]);
+}
+
+//-----------------------------------------------------------------------------
+// ALU
+//-----------------------------------------------------------------------------
+static void alu_add(uint8_t v, int c){
+	unsigned	a = REG_A;
+	unsigned	r = a + v + c;
+	uint8_t		psw = REG_PSW & ~(PSW_CY | PSW_AC | PSW_OV);
+
+	if(r > 0xff) psw |= PSW_CY;
+	if((a & 0x0f) + (v & 0x0f) + c > 0x0f) psw |= PSW_AC;
+	if((a ^ r) & (v ^ r) & 0x80) psw |= PSW_OV;
+	REG_PSW = psw;
+	REG_A = (uint8_t)r;
+}
+
+static void alu_subb(uint8_t v){
+	int		c = CARRY;
+	int		a = REG_A;
+	int		r = a - v - c;
+	uint8_t	psw = REG_PSW & ~(PSW_CY | PSW_AC | PSW_OV);
+
+	if(r < 0) psw |= PSW_CY;
+	if((a & 0x0f) - (v & 0x0f) - c < 0) psw |= PSW_AC;
+	if((a ^ v) & (a ^ r) & 0x80) psw |= PSW_OV;
+	REG_PSW = psw;
+	REG_A = (uint8_t)r;
+}
+
+static void alu_da(void){
+	unsigned	a = REG_A;
+
+	if(((a & 0x0f) > 9) || (REG_PSW & PSW_AC)) a += 0x06;
+	if(a > 0xff) REG_PSW |= PSW_CY;
+	if((((a >> 4) & 0x1f) > 9) || (REG_PSW & PSW_CY)) a += 0x60;
+	if(a > 0xff) REG_PSW |= PSW_CY;
+	REG_A = (uint8_t)a;
+}
+
+// source operand of the A,<src> instruction rows (low nibble 4-f)
+static inline uint8_t src_op(uint8_t op){
+
+	switch(op & 0x0f){
+	case 0x04:
+		return fetch();
+	case 0x05:
+		return rd_dir(fetch());
+	case 0x06:
+	case 0x07:
+		return iram[RN(op & 1)];
+	default:
+		return RN(op & 7);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// interrupts
+//-----------------------------------------------------------------------------
+static void irq_update(sim_time_t t){
+	unsigned	hi;
+	unsigned	now = mcu_irq_pending(&hi);
+	unsigned	raised = now & ~pend;
+
+	while(raised){
+		t_req[__builtin_ctz(raised)] = t;
+		raised &= raised - 1;
+	}
+	pend = now;
+	pend_hi = hi;
+	irq_dirty = 0;
+}
+
+// vector table index that can be taken now, or -1
+static int irq_select(void){
+	unsigned	m;
+
+	if(!pend || block || !(sfr_reg[IE.addr] & 0x80)) return -1;
+	if(depth && nest[depth - 1].hi) return -1;
+	m = pend_hi;
+	if(!m){
+		if(depth) return -1;					// low level is in service
+		m = pend;
+	}
+	return __builtin_ctz(m);
+}
+
+static void vector(int v){
+	uint8_t				num = mcu_irq_num(v);
+	cip51_isr_stats*	s = &cip51_stat.vec[num];
+	uint32_t			lat;
+
+	push((uint8_t)pc);
+	push((uint8_t)(pc >> 8));
+	pc = (uint16_t)(3 + 8 * num);
+	nest[depth].v = v;
+	nest[depth].hi = (pend_hi >> v) & 1;
+	nest[depth].start = cyc;
+	depth++;
+	cyc += VECTOR_CLK;
+	sim_now = cyc;
+	mcu_irq_ack(v);
+	irq_dirty = 1;
+	lat = (uint32_t)(cyc - t_req[v]);
+	s->count++;
+	s->lat_sum += lat;
+	if(lat > s->lat_max) s->lat_max = lat;
+}
+
+static void reti(void){
+	isr_frame*			f;
+	cip51_isr_stats*	s;
+	uint32_t			n;
+
+	if(!depth) return;							// RETI outside an ISR acts as RET
+	f = &nest[--depth];
+	n = (uint32_t)(cyc - f->start);
+	s = &cip51_stat.vec[mcu_irq_num(f->v)];
+	s->cyc_sum += n;
+	if(n > s->cyc_max) s->cyc_max = n;
+	if(!depth) cip51_stat.isr += n;
+	block = 1;
+	irq_dirty = 1;
+}
+
+//-----------------------------------------------------------------------------
+// step() executes one instruction, returns its clock count
+//-----------------------------------------------------------------------------
+static int step(void){
+	uint8_t		op = fetch();
+	int			clk = op_clk[op];
+	uint8_t		a;
+	uint8_t		b;
+	uint8_t		d;
+	int8_t		rel;
+	uint16_t	t;
+
+	switch(op){
+	case 0x00:									// NOP
+		break;
+	case 0x01: case 0x21: case 0x41: case 0x61:	// AJMP
+	case 0x81: case 0xa1: case 0xc1: case 0xe1:
+		a = fetch();
+		pc = (uint16_t)((pc & 0xf800) | ((op & 0xe0) << 3) | a);
+		break;
+	case 0x11: case 0x31: case 0x51: case 0x71:	// ACALL
+	case 0x91: case 0xb1: case 0xd1: case 0xf1:
+		a = fetch();
+		push((uint8_t)pc);
+		push((uint8_t)(pc >> 8));
+		pc = (uint16_t)((pc & 0xf800) | ((op & 0xe0) << 3) | a);
+		break;
+	case 0x02:									// LJMP
+		a = fetch();
+		b = fetch();
+		pc = (uint16_t)((a << 8) | b);
+		break;
+	case 0x12:									// LCALL
+		a = fetch();
+		b = fetch();
+		push((uint8_t)pc);
+		push((uint8_t)(pc >> 8));
+		pc = (uint16_t)((a << 8) | b);
+		break;
+	case 0x22:									// RET
+	case 0x32:									// RETI
+		a = pop();
+		b = pop();
+		pc = (uint16_t)((a << 8) | b);
+		if(op == 0x32) reti();
+		break;
+	case 0x03:									// RR A
+		REG_A = (uint8_t)((REG_A >> 1) | (REG_A << 7));
+		break;
+	case 0x13:									// RRC A
+		a = REG_A;
+		REG_A = (uint8_t)((a >> 1) | (CARRY << 7));
+		set_cy(a & 1);
+		break;
+	case 0x23:									// RL A
+		REG_A = (uint8_t)((REG_A << 1) | (REG_A >> 7));
+		break;
+	case 0x33:									// RLC A
+		a = REG_A;
+		REG_A = (uint8_t)((a << 1) | CARRY);
+		set_cy(a >> 7);
+		break;
+	case 0x04:									// INC A
+		REG_A++;
+		break;
+	case 0x05:									// INC direct
+		a = fetch();
+		wr_dir(a, rd_rmw(a) + 1);
+		break;
+	case 0x06: case 0x07:						// INC @Ri
+		iram[RN(op & 1)]++;
+		break;
+	case 0x08 ... 0x0f:							// INC Rn
+		RN(op & 7)++;
+		break;
+	case 0x14:									// DEC A
+		REG_A--;
+		break;
+	case 0x15:									// DEC direct
+		a = fetch();
+		wr_dir(a, rd_rmw(a) - 1);
+		break;
+	case 0x16: case 0x17:						// DEC @Ri
+		iram[RN(op & 1)]--;
+		break;
+	case 0x18 ... 0x1f:							// DEC Rn
+		RN(op & 7)--;
+		break;
+	case 0x10:									// JBC bit,rel
+	case 0x20:									// JB bit,rel
+	case 0x30:									// JNB bit,rel
+		a = fetch();
+		rel = (int8_t)fetch();
+		d = (op == 0x10) ? rd_bit_rmw(a) : rd_bit(a);
+		if((op == 0x30) ? !d : d){
+			if(op == 0x10) wr_bit(a, 0);
+			pc += rel;
+			clk++;
+		}
+		break;
+	case 0x24 ... 0x2f:							// ADD A,src
+		alu_add(src_op(op), 0);
+		break;
+	case 0x34 ... 0x3f:							// ADDC A,src
+		alu_add(src_op(op), CARRY);
+		break;
+	case 0x94 ... 0x9f:							// SUBB A,src
+		alu_subb(src_op(op));
+		break;
+	case 0x44 ... 0x4f:							// ORL A,src
+		REG_A |= src_op(op);
+		break;
+	case 0x54 ... 0x5f:							// ANL A,src
+		REG_A &= src_op(op);
+		break;
+	case 0x64 ... 0x6f:							// XRL A,src
+		REG_A ^= src_op(op);
+		break;
+	case 0x42:									// ORL direct,A
+		a = fetch();
+		wr_dir(a, rd_rmw(a) | REG_A);
+		break;
+	case 0x43:									// ORL direct,#data
+		a = fetch();
+		d = fetch();
+		wr_dir(a, rd_rmw(a) | d);
+		break;
+	case 0x52:									// ANL direct,A
+		a = fetch();
+		wr_dir(a, rd_rmw(a) & REG_A);
+		break;
+	case 0x53:									// ANL direct,#data
+		a = fetch();
+		d = fetch();
+		wr_dir(a, rd_rmw(a) & d);
+		break;
+	case 0x62:									// XRL direct,A
+		a = fetch();
+		wr_dir(a, rd_rmw(a) ^ REG_A);
+		break;
+	case 0x63:									// XRL direct,#data
+		a = fetch();
+		d = fetch();
+		wr_dir(a, rd_rmw(a) ^ d);
+		break;
+	case 0x40:									// JC rel
+	case 0x50:									// JNC rel
+	case 0x60:									// JZ rel
+	case 0x70:									// JNZ rel
+		rel = (int8_t)fetch();
+		switch(op){
+		case 0x40: d = CARRY; break;
+		case 0x50: d = !CARRY; break;
+		case 0x60: d = (REG_A == 0); break;
+		default: d = (REG_A != 0); break;
+		}
+		if(d){
+			pc += rel;
+			clk++;
+		}
+		break;
+	case 0x72:									// ORL C,bit
+		a = fetch();
+		if(rd_bit(a)) set_cy(1);
+		break;
+	case 0xa0:									// ORL C,/bit
+		a = fetch();
+		if(!rd_bit(a)) set_cy(1);
+		break;
+	case 0x82:									// ANL C,bit
+		a = fetch();
+		if(!rd_bit(a)) set_cy(0);
+		break;
+	case 0xb0:									// ANL C,/bit
+		a = fetch();
+		if(rd_bit(a)) set_cy(0);
+		break;
+	case 0x73:									// JMP @A+DPTR
+		pc = (uint16_t)(dptr() + REG_A);
+		break;
+	case 0x74:									// MOV A,#data
+		REG_A = fetch();
+		break;
+	case 0x75:									// MOV direct,#data
+		a = fetch();
+		d = fetch();
+		wr_dir(a, d);
+		break;
+	case 0x76: case 0x77:						// MOV @Ri,#data
+		iram[RN(op & 1)] = fetch();
+		break;
+	case 0x78 ... 0x7f:							// MOV Rn,#data
+		RN(op & 7) = fetch();
+		break;
+	case 0x80:									// SJMP rel
+		rel = (int8_t)fetch();
+		pc += rel;
+		break;
+	case 0x83:									// MOVC A,@A+PC
+		REG_A = code[(uint16_t)(pc + REG_A) & (CIP51_CODE - 1)];
+		break;
+	case 0x93:									// MOVC A,@A+DPTR
+		REG_A = code[(uint16_t)(dptr() + REG_A) & (CIP51_CODE - 1)];
+		break;
+	case 0x84:									// DIV AB
+		REG_PSW &= ~(PSW_CY | PSW_OV);
+		if(REG_B == 0){
+			REG_PSW |= PSW_OV;
+		}else{
+			a = REG_A / REG_B;
+			REG_B = REG_A % REG_B;
+			REG_A = a;
+		}
+		break;
+	case 0xa4:									// MUL AB
+		t = (uint16_t)(REG_A * REG_B);
+		REG_PSW &= ~(PSW_CY | PSW_OV);
+		if(t > 0xff) REG_PSW |= PSW_OV;
+		REG_A = (uint8_t)t;
+		REG_B = (uint8_t)(t >> 8);
+		break;
+	case 0x85:									// MOV direct,direct (src first)
+		a = fetch();
+		b = fetch();
+		wr_dir(b, rd_dir(a));
+		break;
+	case 0x86: case 0x87:						// MOV direct,@Ri
+		a = fetch();
+		wr_dir(a, iram[RN(op & 1)]);
+		break;
+	case 0x88 ... 0x8f:							// MOV direct,Rn
+		a = fetch();
+		wr_dir(a, RN(op & 7));
+		break;
+	case 0x90:									// MOV DPTR,#data16
+		sfr_reg[DPH.addr] = fetch();
+		sfr_reg[DPL.addr] = fetch();
+		break;
+	case 0x92:									// MOV bit,C
+		a = fetch();
+		wr_bit(a, CARRY);
+		break;
+	case 0xa2:									// MOV C,bit
+		a = fetch();
+		set_cy(rd_bit(a));
+		break;
+	case 0xa3:									// INC DPTR
+		t = (uint16_t)(dptr() + 1);
+		sfr_reg[DPH.addr] = (uint8_t)(t >> 8);
+		sfr_reg[DPL.addr] = (uint8_t)t;
+		break;
+	case 0xa5:									// reserved
+		cip51_stat.bad_ops++;
+		break;
+	case 0xa6: case 0xa7:						// MOV @Ri,direct
+		a = fetch();
+		iram[RN(op & 1)] = rd_dir(a);
+		break;
+	case 0xa8 ... 0xaf:							// MOV Rn,direct
+		a = fetch();
+		RN(op & 7) = rd_dir(a);
+		break;
+	case 0xb2:									// CPL bit
+		a = fetch();
+		wr_bit(a, !rd_bit_rmw(a));
+		break;
+	case 0xb3:									// CPL C
+		REG_PSW ^= PSW_CY;
+		break;
+	case 0xb4 ... 0xbf:							// CJNE
+		switch(op){
+		case 0xb4: a = REG_A; b = fetch(); break;
+		case 0xb5: a = REG_A; b = rd_dir(fetch()); break;
+		case 0xb6: case 0xb7: a = iram[RN(op & 1)]; b = fetch(); break;
+		default: a = RN(op & 7); b = fetch(); break;
+		}
+		rel = (int8_t)fetch();
+		set_cy(a < b);
+		if(a != b){
+			pc += rel;
+			clk++;
+		}
+		break;
+	case 0xc0:									// PUSH direct
+		a = fetch();
+		push(rd_dir(a));
+		break;
+	case 0xd0:									// POP direct
+		a = fetch();
+		wr_dir(a, pop());
+		break;
+	case 0xc2:									// CLR bit
+		wr_bit(fetch(), 0);
+		break;
+	case 0xd2:									// SETB bit
+		wr_bit(fetch(), 1);
+		break;
+	case 0xc3:									// CLR C
+		set_cy(0);
+		break;
+	case 0xd3:									// SETB C
+		set_cy(1);
+		break;
+	case 0xc4:									// SWAP A
+		REG_A = (uint8_t)((REG_A << 4) | (REG_A >> 4));
+		break;
+	case 0xc5:									// XCH A,direct
+		a = fetch();
+		d = rd_rmw(a);
+		wr_dir(a, REG_A);
+		REG_A = d;
+		break;
+	case 0xc6: case 0xc7:						// XCH A,@Ri
+		d = iram[RN(op & 1)];
+		iram[RN(op & 1)] = REG_A;
+		REG_A = d;
+		break;
+	case 0xc8 ... 0xcf:							// XCH A,Rn
+		d = RN(op & 7);
+		RN(op & 7) = REG_A;
+		REG_A = d;
+		break;
+	case 0xd4:									// DA A
+		alu_da();
+		break;
+	case 0xd5:									// DJNZ direct,rel
+		a = fetch();
+		rel = (int8_t)fetch();
+		d = rd_rmw(a) - 1;
+		wr_dir(a, d);
+		if(d){
+			pc += rel;
+			clk++;
+		}
+		break;
+	case 0xd6: case 0xd7:						// XCHD A,@Ri
+		d = iram[RN(op & 1)];
+		iram[RN(op & 1)] = (uint8_t)((d & 0xf0) | (REG_A & 0x0f));
+		REG_A = (uint8_t)((REG_A & 0xf0) | (d & 0x0f));
+		break;
+	case 0xd8 ... 0xdf:							// DJNZ Rn,rel
+		rel = (int8_t)fetch();
+		if(--RN(op & 7)){
+			pc += rel;
+			clk++;
+		}
+		break;
+	case 0xe0:									// MOVX A,@DPTR
+		REG_A = xram[dptr() & (CIP51_XRAM - 1)];
+		break;
+	case 0xe2: case 0xe3:						// MOVX A,@Ri
+		REG_A = xram[RN(op & 1)];
+		break;
+	case 0xf0:									// MOVX @DPTR,A
+		if(sfr_reg[PSCTL.addr] & PSCTL_PSWE) *cseg_ptr(dptr() & (CIP51_CODE - 1)) = REG_A;
+		else xram[dptr() & (CIP51_XRAM - 1)] = REG_A;
+		break;
+	case 0xf2: case 0xf3:						// MOVX @Ri,A
+		xram[RN(op & 1)] = REG_A;
+		break;
+	case 0xe4:									// CLR A
+		REG_A = 0;
+		break;
+	case 0xe5:									// MOV A,direct
+		REG_A = rd_dir(fetch());
+		break;
+	case 0xe6: case 0xe7:						// MOV A,@Ri
+		REG_A = iram[RN(op & 1)];
+		break;
+	case 0xe8 ... 0xef:							// MOV A,Rn
+		REG_A = RN(op & 7);
+		break;
+	case 0xf4:									// CPL A
+		REG_A = (uint8_t)~REG_A;
+		break;
+	case 0xf5:									// MOV direct,A
+		wr_dir(fetch(), REG_A);
+		break;
+	case 0xf6: case 0xf7:						// MOV @Ri,A
+		iram[RN(op & 1)] = REG_A;
+		break;
+	case 0xf8 ... 0xff:							// MOV Rn,A
+		RN(op & 7) = REG_A;
+		break;
+	default:
+		sim_fatal("cip51: opcode not decoded");
+	}
+	return clk;
+}
+
+//-----------------------------------------------------------------------------
+// cip51_run() runs the loaded image from reset until virtual time "end".
+//	Events due before the end of an instruction fire at their own time, so
+//	PCA captures and UART flags carry hardware timing; the CPU sees them at
+//	the next instruction boundary.
+//-----------------------------------------------------------------------------
+void cip51_run(sim_time_t end){
+	sim_time_t	t;
+	int			v;
+	int			clk;
+
+	sim_ext_begin(end);
+	while(cyc < end){
+		while((t = sim_next()) <= cyc){
+			sim_fire();
+			irq_update(t);
+		}
+		sim_now = cyc;
+		if(irq_dirty) irq_update(cyc);
+		v = irq_select();
+		if((v >= 0) && (t_req[v] < cyc)){		// one clock to see the request
+			if(idle){
+				idle = 0;
+				wake = cyc;
+			}
+			vector(v);
+			continue;
+		}
+		if(idle){								// sleep to the next event (or the
+			t = (v >= 0) ? cyc + 1 : sim_next();	//	clock that sees a request)
+			if(t > end) t = end;
+			cip51_stat.idle += t - cyc;
+			cyc = t;
+			continue;
+		}
+		block = 0;								// this is the held-off instruction
+		clk = step();
+		cip51_stat.instr++;
+		if(!depth) pass_cyc += clk;
+		if(REG_SP > cip51_stat.sp_max) cip51_stat.sp_max = REG_SP;
+		cyc += clk;
+	}
+	cip51_stat.cycles = end;
+	sim_now = end;
+}
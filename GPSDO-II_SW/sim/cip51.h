@@ -0,0 +1,72 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: cip51.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This is the header file for the cycle-counting CIP-51
+ *             instruction-set simulator used by gpsdo_iss.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+#ifndef SIM_CIP51_H
+#define SIM_CIP51_H
+
+#include <stdint.h>
+#include "kernel.h"
+
+//------------------------------------------------------------------------------
+// extern defines
+//------------------------------------------------------------------------------
+
+#define	CIP51_CODE		0x2000				// F520 flash, bytes
+#define	CIP51_XRAM		0x100				// on-chip XRAM, bytes
+
+// cip51_load() return codes
+#define	HEX_OK			0
+#define	HEX_OPEN		1					// can't open the file
+#define	HEX_FORMAT		2					// bad record or checksum
+#define	HEX_RANGE		3					// data outside the code space
+
+struct cip51_isr_stats {
+	uint32_t	count;						// entries
+	uint64_t	lat_sum;					// request to first ISR instruction, cycles
+	uint32_t	lat_max;
+	uint64_t	cyc_sum;					// vectoring through RETI, cycles
+	uint32_t	cyc_max;
+};
+
+struct cip51_stats {
+	uint64_t	instr;						// instructions executed
+	uint64_t	cycles;						// SYSCLK cycles run
+	uint64_t	idle;						// cycles in IDLE mode
+	uint64_t	isr;						// cycles from vectoring to RETI (outermost ISR)
+	uint64_t	boot;						// reset to the first IDLE, cycles
+	uint64_t	passes;						// main loop passes (IDLE to IDLE, after boot)
+	uint64_t	pass_sum;					// main context cycles per pass
+	uint32_t	pass_max;
+	uint32_t	pass_span_max;				// wake to IDLE, ISRs included
+	uint32_t	bad_ops;					// reserved opcode (0xA5) executed
+	uint8_t		sp_max;						// stack high-water mark
+	cip51_isr_stats	vec[16];				// by interrupt number
+};
+
+extern cip51_stats cip51_stat;
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+int cip51_load(const char* path);			// Intel HEX into the code space
+void cip51_reset(void);
+void cip51_run(sim_time_t end);
+
+#endif
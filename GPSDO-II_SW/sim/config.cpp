@@ -0,0 +1,212 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: config.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   gpsdo_sim run configuration.  The key table below is the only
+ *             place a parameter needs to be added.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  fw.* and settle.y keys
+ *    10-17-26 jmh:  gps.capture, gps.replay
+ *    10-17-26 jmh:  temp.step_at, temp.step
+ *    10-17-26 jmh:  fw.qerr
+ *    10-17-26 jmh:  fw.fuse
+ *    10-17-26 jmh:  fw.tau0, fw.tau1; fw.kp is the TRACK damping
+ *    10-17-26 jmh:  gps.deg_at, gps.deg_len, gps.deg_acc, gps.glitch, gps.glitch_size
+ *    10-17-26 jmh:  fw.fuse removed (PCA_FUSE is gone)
+ *
+ *******************************************************************/
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "config.h"
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+		sim_config	sim_cfg;
+
+enum cfg_type { CFG_DBL, CFG_U32, CFG_STR };
+
+struct cfg_key {
+	const char*	name;
+	cfg_type	type;
+	size_t		offs;
+	const char*	help;
+};
+
+#define	KEY(name, type, field, help)	{ name, type, offsetof(sim_config, field), help }
+
+static const cfg_key keys[] = {
+	KEY("hours",			CFG_DBL, hours,			"run length, hours"),
+	KEY("seed",				CFG_U32, seed,			"random seed"),
+	KEY("osc.f0",			CFG_DBL, osc_f0,		"nominal VCO frequency, Hz"),
+	KEY("osc.null_dac",		CFG_DBL, osc_null_dac,	"DAC code for zero frequency offset"),
+	KEY("osc.slope",		CFG_DBL, osc_slope,		"fractional frequency per DAC LSB"),
+	KEY("osc.age1",			CFG_DBL, osc_age1,		"linear aging, per day"),
+	KEY("osc.age2",			CFG_DBL, osc_age2,		"quadratic aging, per day^2"),
+	KEY("osc.tempco",		CFG_DBL, osc_tempco,	"frequency tempco, per C"),
+	KEY("osc.tref",			CFG_DBL, osc_tref,		"tempco reference temperature, C"),
+	KEY("osc.wpm",			CFG_DBL, osc_wpm,		"white PM on divider edges, s rms"),
+	KEY("osc.wfm",			CFG_DBL, osc_wfm,		"white FM noise, ADEV at 1 s"),
+	KEY("osc.ffm",			CFG_DBL, osc_ffm,		"flicker FM noise, ADEV floor"),
+	KEY("osc.rwfm",			CFG_DBL, osc_rwfm,		"random walk FM noise, ADEV at 1 s"),
+	KEY("osc.dt",			CFG_DBL, osc_dt,		"noise/thermal update interval, s"),
+	KEY("div.period",		CFG_DBL, div_period,	"divider period at f0, s"),
+	KEY("gps.week",			CFG_DBL, gps_week,		"GPS week at t = 0"),
+	KEY("gps.tow0",			CFG_DBL, gps_tow0,		"GPS time-of-week at t = 0, s"),
+	KEY("gps.fix",			CFG_DBL, gps_fix,		"time to first fix, s"),
+	KEY("gps.loss_at",		CFG_DBL, gps_loss_at,	"GPS outage start, s (< 0 = none)"),
+	KEY("gps.loss_len",		CFG_DBL, gps_loss_len,	"GPS outage length, s"),
+	KEY("gps.tm2_delay",	CFG_DBL, gps_tm2_delay,	"TIM-TM2 delay after the epoch, s"),
+	KEY("gps.acc",			CFG_DBL, gps_acc,		"TIM-TM2 accEst, ns"),
+	KEY("gps.quant",		CFG_DBL, gps_quant,		"receiver clock period, s"),
+	KEY("gps.drift",		CFG_DBL, gps_drift,		"receiver clock offset (sawtooth rate)"),
+	KEY("gps.noise",		CFG_DBL, gps_noise,		"time-mark noise, s rms"),
+	KEY("gps.drop",			CFG_DBL, gps_drop,		"TIM-TM2 loss probability"),
+	KEY("gps.corrupt",		CFG_DBL, gps_corrupt,	"per-byte bit error probability"),
+	KEY("gps.deg_at",		CFG_DBL, gps_deg_at,	"degraded timing start, s (< 0 = none)"),
+	KEY("gps.deg_len",		CFG_DBL, gps_deg_len,	"degraded timing length, s"),
+	KEY("gps.deg_acc",		CFG_DBL, gps_deg_acc,	"accEst while degraded, ns (noise scales with it)"),
+	KEY("gps.glitch",		CFG_DBL, gps_glitch,	"probability a time mark is off by gps.glitch_size"),
+	KEY("gps.glitch_size",	CFG_DBL, gps_glitch_size, "time-mark glitch, s"),
+	KEY("gps.nmea",			CFG_U32, gps_nmea,		"NMEA traffic: 0 none, 1 RMC/GGA, 2 full set"),
+	KEY("gps.ubx",			CFG_U32, gps_ubx,		"1 = NAV-STATUS/NAV-PVT traffic"),
+	KEY("gps.timtp",		CFG_U32, gps_timtp,		"1 = TIM-TP traffic"),
+	KEY("gps.capture",		CFG_STR, gps_capture,	"write the receiver UART stream to this file"),
+	KEY("gps.replay",		CFG_STR, gps_replay,	"send this file on the UART instead"),
+	KEY("flash.dac",		CFG_DBL, flash_dac,		"preloaded dac_save[0] (< 0 = erased)"),
+	KEY("temp",				CFG_DBL, temp,			"ambient temperature, C"),
+	KEY("temp.tau",			CFG_DBL, temp_tau,		"enclosure thermal time constant, s"),
+	KEY("temp.tec",			CFG_DBL, temp_tec,		"TEC slew at full drive, C/s"),
+	KEY("temp.step_at",		CFG_DBL, temp_step_at,	"ambient step time, s (< 0 = none)"),
+	KEY("temp.step",		CFG_DBL, temp_step,		"ambient step, C"),
+	KEY("trace",			CFG_STR, trace,			"per-edge CSV trace file"),
+	KEY("settle.y",			CFG_DBL, settle_y,		"settle time band, fractional frequency"),
+	KEY("fw.kp",			CFG_U32, fw_kp,			"firmware KP (TRACK damping numerator)"),
+	KEY("fw.kpd",			CFG_U32, fw_kpd,		"firmware KPD (TRACK damping denominator)"),
+	KEY("fw.ave_count",		CFG_U32, fw_ave_count,	"firmware AVE_COUNT (longest TRACK window, DIV_MS periods)"),
+	KEY("fw.gps_timeout",	CFG_DBL, fw_gps_timeout, "firmware GPS_TIMEOUT, s"),
+	KEY("fw.qerr",			CFG_U32, fw_qerr,		"firmware TP_QERR (1 = TIM-TP qErr correction)"),
+	KEY("fw.tau0",			CFG_U32, fw_tau0,		"firmware PI_TAU0 (TRACK time constant out of AQS, s)"),
+	KEY("fw.tau1",			CFG_U32, fw_tau1,		"firmware PI_TAU1 (longest TRACK time constant, s)"),
+};
+#define	NUM_KEYS	(int)(sizeof(keys) / sizeof(keys[0]))
+
+//-----------------------------------------------------------------------------
+// config_defaults() loads the nominal GPSDO-II board
+//-----------------------------------------------------------------------------
+void config_defaults(void){
+
+	memset(&sim_cfg, 0, sizeof(sim_cfg));
+	sim_cfg.hours = 24.0;
+	sim_cfg.seed = 1;
+	sim_cfg.osc_f0 = 10e6;
+	sim_cfg.osc_null_dac = 33966.0;				// measured on the MK-II prototype
+	sim_cfg.osc_slope = 3.5e-10;				// ~100 DAC LSB per 175 ns / 5 s
+	sim_cfg.osc_age1 = 5e-11;
+	sim_cfg.osc_age2 = 0.0;
+	sim_cfg.osc_tempco = 1e-11;
+	sim_cfg.osc_tref = 25.0;
+	sim_cfg.osc_wpm = 1e-10;
+	sim_cfg.osc_wfm = 1e-11;
+	sim_cfg.osc_ffm = 5e-12;
+	sim_cfg.osc_rwfm = 3e-14;
+	sim_cfg.osc_dt = 1.0;
+	sim_cfg.div_period = 5.0;
+	sim_cfg.gps_week = 2230.0;
+	sim_cfg.gps_tow0 = 345600.3;
+	sim_cfg.gps_fix = 5.0;
+	sim_cfg.gps_loss_at = -1.0;
+	sim_cfg.gps_loss_len = 0.0;
+	sim_cfg.gps_tm2_delay = 0.05;
+	sim_cfg.gps_acc = 20.0;
+	sim_cfg.gps_quant = 1.0 / 48e6;				// 48 MHz receiver clock
+	sim_cfg.gps_drift = 3.7e-8;
+	sim_cfg.gps_noise = 5e-9;
+	sim_cfg.gps_drop = 0.0;
+	sim_cfg.gps_corrupt = 0.0;
+	sim_cfg.gps_deg_at = -1.0;
+	sim_cfg.gps_deg_len = 0.0;
+	sim_cfg.gps_deg_acc = 200.0;
+	sim_cfg.gps_glitch = 0.0;
+	sim_cfg.gps_glitch_size = 500e-9;
+	sim_cfg.gps_nmea = 1;
+	sim_cfg.gps_ubx = 0;
+	sim_cfg.gps_timtp = 0;
+	sim_cfg.flash_dac = -1.0;
+	sim_cfg.temp = 25.0;
+	sim_cfg.temp_tau = 900.0;
+	sim_cfg.temp_tec = 0.01;
+	sim_cfg.temp_step_at = -1.0;
+	sim_cfg.temp_step = 0.0;
+	sim_cfg.settle_y = 1e-9;
+	sim_cfg.fw_kp = 1264;						// init.h
+	sim_cfg.fw_kpd = 1000;
+	sim_cfg.fw_ave_count = 5;
+	sim_cfg.fw_gps_timeout = 12.5;
+	sim_cfg.fw_qerr = 0;
+	sim_cfg.fw_tau0 = 40;
+	sim_cfg.fw_tau1 = 640;
+}
+
+//-----------------------------------------------------------------------------
+// config_set() parses one key=value
+//-----------------------------------------------------------------------------
+int config_set(const char* arg){
+	const char*	eq = strchr(arg, '=');
+	char*		p;
+	char*		end;
+	int			i;
+
+	if(!eq) return -1;
+	for(i=0; i<NUM_KEYS; i++){
+		if((strlen(keys[i].name) == (size_t)(eq - arg)) && !strncmp(keys[i].name, arg, eq - arg)) break;
+	}
+	if(i == NUM_KEYS) return -1;
+	p = (char*)&sim_cfg + keys[i].offs;
+	switch(keys[i].type){
+	case CFG_DBL:
+		*(double*)p = strtod(eq + 1, &end);
+		break;
+	case CFG_U32:
+		*(uint32_t*)p = (uint32_t)strtoul(eq + 1, &end, 0);
+		break;
+	default:
+		if(strlen(eq + 1) >= CFG_PATH_LEN) return -1;
+		strcpy(p, eq + 1);
+		return 0;
+	}
+	return ((end == eq + 1) || *end) ? -1 : 0;
+}
+
+int config_parse(int argc, char** argv){
+	int	i;
+
+	for(i=1; i<argc; i++){
+		if(config_set(argv[i])){
+			fprintf(stderr, "gpsdo_sim: bad parameter \"%s\"\n", argv[i]);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+void config_usage(FILE* fp){
+	int	i;
+
+	fprintf(fp, "usage: gpsdo_sim [key=value ...]\n");
+	for(i=0; i<NUM_KEYS; i++){
+		fprintf(fp, "  %-16s %s\n", keys[i].name, keys[i].help);
+	}
+}
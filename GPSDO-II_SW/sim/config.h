@@ -0,0 +1,112 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: config.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This is the header file for the gpsdo_sim run configuration.
+ *             Every parameter is set on the command line as key=value (see
+ *             "gpsdo_sim help" for the list).
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  fw.* keys: init.h loop parameters at run time
+ *    10-17-26 jmh:  gps.capture, gps.replay
+ *    10-17-26 jmh:  temp.step_at, temp.step
+ *    10-17-26 jmh:  fw.qerr
+ *    10-17-26 jmh:  fw.fuse
+ *    10-17-26 jmh:  fw.tau0, fw.tau1
+ *    10-17-26 jmh:  gps.deg_at, gps.deg_len, gps.deg_acc, gps.glitch, gps.glitch_size
+ *    10-17-26 jmh:  fw.fuse removed
+ *
+ *******************************************************************/
+
+#ifndef SIM_CONFIG_H
+#define SIM_CONFIG_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// extern defines
+//------------------------------------------------------------------------------
+
+#define	CFG_PATH_LEN	256
+
+struct sim_config {
+	double		hours;						// run length
+	uint32_t	seed;						// random seed
+	// oscillator (OCXO + tuning input)
+	double		osc_f0;						// nominal VCO frequency, Hz
+	double		osc_null_dac;				// DAC code (0-5V range) for zero offset
+	double		osc_slope;					// fractional frequency per DAC LSB
+	double		osc_age1;					// linear aging, per day
+	double		osc_age2;					// quadratic aging, per day^2
+	double		osc_tempco;					// per C of enclosure temperature
+	double		osc_tref;					// tempco reference temperature, C
+	double		osc_wpm;					// white PM on the divider edges, s rms
+	double		osc_wfm;					// white FM, ADEV at 1 s
+	double		osc_ffm;					// flicker FM, ADEV floor
+	double		osc_rwfm;					// random walk FM, ADEV at 1 s
+	double		osc_dt;						// noise/thermal update interval, s
+	// divider chain
+	double		div_period;					// seconds per divider cycle at f0
+	// GPS receiver
+	double		gps_week;					// GPS week at t = 0
+	double		gps_tow0;					// GPS time-of-week at t = 0, s
+	double		gps_fix;					// time to first fix, s
+	double		gps_loss_at;				// start of a GPS outage, s (< 0 = none)
+	double		gps_loss_len;				// length of the outage, s
+	double		gps_tm2_delay;				// TIM-TM2 output delay after the epoch, s
+	double		gps_acc;					// reported accEst, ns
+	double		gps_quant;					// receiver clock period, s (sawtooth)
+	double		gps_drift;					// receiver clock fractional offset
+	double		gps_noise;					// time-mark noise, s rms
+	double		gps_drop;					// TIM-TM2 loss probability
+	double		gps_corrupt;				// per-byte bit error probability
+	double		gps_deg_at;					// start of degraded timing, s (< 0 = none)
+	double		gps_deg_len;				// its length, s
+	double		gps_deg_acc;				// accEst while degraded, ns (noise goes up with it)
+	double		gps_glitch;					// probability a time mark is off by gps_glitch_size
+	double		gps_glitch_size;			// s
+	uint32_t	gps_nmea;					// NMEA per epoch: 0 none, 1 RMC/GGA, 2 all
+	uint32_t	gps_ubx;					// 1 = NAV-STATUS/NAV-PVT every epoch
+	uint32_t	gps_timtp;					// 1 = TIM-TP every epoch
+	char		gps_capture[CFG_PATH_LEN];	// UART stream to this file ("" = none)
+	char		gps_replay[CFG_PATH_LEN];	// UART stream from this file ("" = modelled)
+	// board
+	double		flash_dac;					// preloaded dac_save[0] (< 0 = erased)
+	double		temp;						// ambient temperature, C
+	double		temp_tau;					// enclosure thermal time constant, s
+	double		temp_tec;					// TEC slew at full drive, C/s
+	double		temp_step_at;				// ambient step time, s (< 0 = none)
+	double		temp_step;					// ambient step, C
+	char		trace[CFG_PATH_LEN];		// per-edge CSV trace file ("" = none)
+	double		settle_y;					// settle time frequency band, fractional
+	// firmware loop parameters (init.h KP, KPD, AVE_COUNT, GPS_TIMEOUT, TP_QERR, PI_TAU0, PI_TAU1)
+	uint32_t	fw_kp;
+	uint32_t	fw_kpd;
+	uint32_t	fw_ave_count;
+	double		fw_gps_timeout;				// s
+	uint32_t	fw_qerr;
+	uint32_t	fw_tau0;					// s
+	uint32_t	fw_tau1;					// s
+};
+
+extern sim_config sim_cfg;
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+void config_defaults(void);
+int config_set(const char* arg);			// parse one key=value, 0 = OK
+int config_parse(int argc, char** argv);	// parse argv[1..], 0 = OK
+void config_usage(FILE* fp);
+
+#endif
@@ -0,0 +1,89 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: cseg.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   Host image of the F520 code space from the flash scratchpad
+ *             up.  nvmem.c places dac_save[] in the "cseg" section (see
+ *             keil51.h); this file is linked directly after nvmem.o so that
+ *             cseg_pad[] follows it.
+ *
+ *             The pad matters: when the scratchpad is empty find_flash()
+ *             returns 0xffff, and read_flast() then reads dac_save[0xffff].
+ *             On the target that address wraps to 0x1BFE, which is erased
+ *             flash, so the firmware sees 0xffff and takes the "flash empty"
+ *             path.  The pad is erased (0xff) and large enough to cover the
+ *             full U16 index range.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+#include <string.h>
+#include "kernel.h"
+#include "cseg.h"
+
+//------------------------------------------------------------------------------
+// firmware objects (nvmem.c, flash.c)
+//------------------------------------------------------------------------------
+
+extern unsigned short dac_save[];
+unsigned char erase_flash(unsigned char* addr);
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+#define	PAD_SIZE	0x20000
+
+__attribute__((section("cseg"))) unsigned char cseg_pad[PAD_SIZE];
+
+//-----------------------------------------------------------------------------
+// cseg_init() erases the scratchpad and pad, and checks the link order
+//-----------------------------------------------------------------------------
+void cseg_init(void){
+	uint8_t*	base = (uint8_t*)dac_save;
+
+	if((cseg_pad < base + FLASH_WORDS * 2) || (cseg_pad > base + FLASH_SECTOR)){
+		sim_fatal("cseg_pad does not follow dac_save[] (link order)");
+	}
+	memset(base, 0xff, cseg_pad - base);
+	memset(cseg_pad, 0xff, PAD_SIZE);
+}
+
+//-----------------------------------------------------------------------------
+// cseg_ptr() maps a code address at or above FLASH_START to the host image
+//-----------------------------------------------------------------------------
+uint8_t* cseg_ptr(uint32_t addr){
+
+	if((addr < FLASH_START) || (addr >= FLASH_START + PAD_SIZE)) sim_fatal("code address not mapped");
+	return (uint8_t*)dac_save + (addr - FLASH_START);
+}
+
+void cseg_set_dac(int dac){
+
+	if(dac >= 0) dac_save[0] = (unsigned short)dac;
+}
+
+int cseg_dac_count(void){
+	int	i;
+
+	for(i=0; (i<FLASH_WORDS) && (dac_save[i] != 0xffff); i++);
+	return i;
+}
+
+//-----------------------------------------------------------------------------
+// erase_flash(START_ADDR): C51 passes the integer address as an xdata
+//	pointer; see keil51.h
+//-----------------------------------------------------------------------------
+unsigned char erase_flash(unsigned int xaddr){
+
+	return erase_flash(cseg_ptr(xaddr));
+}
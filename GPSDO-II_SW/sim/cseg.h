@@ -0,0 +1,42 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: cseg.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This is the header file for the host image of the F520
+ *             code space around the flash scratchpad (dac_save[]).
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+#ifndef SIM_CSEG_H
+#define SIM_CSEG_H
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// extern defines
+//------------------------------------------------------------------------------
+
+#define	FLASH_START		0x1C00				// START_ADDR in nvmem.h
+#define	FLASH_SECTOR	512
+#define	FLASH_WORDS		255					// MAXARY in nvmem.h
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+void cseg_init(void);
+uint8_t* cseg_ptr(uint32_t addr);
+void cseg_set_dac(int dac);					// preload dac_save[0] (-1 = erased)
+int cseg_dac_count(void);					// programmed words in dac_save[]
+
+#endif
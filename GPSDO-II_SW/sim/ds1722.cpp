@@ -0,0 +1,137 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: ds1722.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   DS1722 SPI temperature sensor.  CE is active high.  The first
+ *             byte of a transfer is the address (A7 = 1 for a write), data
+ *             bytes follow with the address auto-incrementing.  Registers:
+ *             0 = config, 1 = temperature LSB, 2 = temperature MSB.
+ *
+ *             The sensor powers up shut down (config 0xE1).  Once SD is
+ *             cleared it converts continuously at the selected resolution;
+ *             the temperature register holds the last completed conversion.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+#include <math.h>
+#include "kernel.h"
+#include "board.h"
+#include "plant.h"
+#include "ds1722.h"
+
+//------------------------------------------------------------------------------
+// local defines
+//------------------------------------------------------------------------------
+
+#define	CFG_SD		0x01					// shutdown
+#define	CFG_RES(c)	(((c) >> 1) & 0x07)		// 0..3 = 8..11 bits, 4..7 = 12 bits
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+static	uint8_t		cfg;
+static	uint8_t		addr;
+static	int			first;					// next byte is the address
+static	int16_t		treg;					// temperature register
+static	sim_time_t	conv_done;				// end of the conversion in progress
+
+//-----------------------------------------------------------------------------
+// conversion time, 75 ms at 8 bits doubling per bit
+//-----------------------------------------------------------------------------
+static sim_time_t conv_time(void){
+	int	r = CFG_RES(cfg);
+
+	if(r > 4) r = 4;
+	return sim_cycles(0.075L * (1 << r));
+}
+
+//-----------------------------------------------------------------------------
+// convert() brings the temperature register up to date
+//-----------------------------------------------------------------------------
+static void convert(void){
+	int		r = CFG_RES(cfg);
+	double	lsb;
+
+	if(cfg & CFG_SD) return;
+	if(sim_now < conv_done) return;
+	if(r > 4) r = 4;
+	lsb = 256.0 / (1 << r);						// register units (1/256 C)
+	treg = (int16_t)(floor(plant_sensor_temp() * 256.0 / lsb) * lsb);
+	conv_done = sim_now + conv_time();
+}
+
+int16_t ds1722_temp(void){
+
+	convert();
+	return treg;
+}
+
+//-----------------------------------------------------------------------------
+// SPI slave interface
+//-----------------------------------------------------------------------------
+static void ts_select(int on){
+
+	first = on;
+}
+
+static uint8_t ts_tx(void){
+	uint8_t	c = 0xff;
+
+	if(first || (addr & 0x80)) return c;
+	convert();
+	switch(addr){
+	case 0x00:
+		c = cfg;
+		break;
+	case 0x01:
+		c = (uint8_t)treg;
+		break;
+	case 0x02:
+		c = (uint8_t)(treg >> 8);
+		break;
+	default:
+		break;
+	}
+	addr = (addr + 1) % 3;
+	return c;
+}
+
+static void ts_rx(uint8_t c){
+
+	if(first){
+		addr = c;
+		first = 0;
+		return;
+	}
+	if(!(addr & 0x80)) return;
+	if((addr & 0x7f) == 0x00){
+		if((cfg & CFG_SD) && !(c & CFG_SD)) conv_done = sim_now + conv_time();
+		cfg = (uint8_t)(c | 0xe0);
+	}
+	addr = (uint8_t)(0x80 | (((addr & 0x7f) + 1) % 3));
+}
+
+spi_dev ds1722_dev = { "DS1722", ts_select, ts_tx, ts_rx };
+
+//-----------------------------------------------------------------------------
+// ds1722_init() is a power-on reset
+//-----------------------------------------------------------------------------
+void ds1722_init(void){
+
+	cfg = 0xe1;
+	addr = 0;
+	first = 0;
+	treg = 0;
+	conv_done = SIM_NEVER;
+}
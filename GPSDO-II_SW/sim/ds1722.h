@@ -0,0 +1,32 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: ds1722.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This is the header file for the DS1722 temperature sensor
+ *             model.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+#ifndef SIM_DS1722_H
+#define SIM_DS1722_H
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+void ds1722_init(void);
+int16_t ds1722_temp(void);					// temperature register, 1/256 C
+
+#endif
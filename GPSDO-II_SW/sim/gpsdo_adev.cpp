@@ -0,0 +1,282 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: gpsdo_adev.cpp
+ *
+ *  Module:    Analysis
+ *
+ *  Summary:   gpsdo_adev: ADEV/MDEV/TDEV of a phase log in one streaming
+ *             pass (see adev.cpp).  The log is read line by line (or frame
+ *             by frame) and never held in memory, so month-long logs at 1 s
+ *             or 5 s are fine.
+ *
+ *             gpsdo_adev [key=value ...] [file]       (stdin if no file)
+ *
+ *             fmt=text   whitespace/comma separated columns; lines that do
+ *                        not start with a number are skipped (headers)
+ *             fmt=ubx    raw receiver capture: phase is taken from each
+ *                        TIM-TM2 that getm() would accept (checksum good,
+ *                        channel 0, time valid, rising edge) as
+ *                        (towMsR mod 1000) ms + towSubMsR ns
+ *
+ *             With tcol= (text) or with fmt=ubx the sample times are used
+ *             to find missing samples; otherwise every line is one tau0.
+ *             wrap= unwraps a phase that is only known modulo a period
+ *             (1e6 for bare towSubMsR in ns).
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "adev.h"
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+struct adev_cfg {
+	double		tau0;						// sample interval, s
+	uint32_t	col;						// phase column (text, 1 = first)
+	uint32_t	tcol;						// time column (0 = none)
+	double		scale;						// input units to seconds
+	double		wrap;						// unwrap modulus, input units (0 = none)
+	uint32_t	mmax;						// largest averaging factor
+	int			ubx;						// input is a UBX capture
+};
+
+static	adev_cfg	cfg;
+static	adev_state	eng;
+static	int			have_t;					// sample time tracking
+static	double		t_next;
+static	int			have_ph;				// unwrap state
+static	double		ph_last;
+static	double		ph_off;
+static	uint64_t	n_in;					// samples read
+static	uint64_t	n_gap;					// samples inserted as missing
+static	uint64_t	n_late;					// samples out of order / duplicated
+
+#define	UBX_TIM_TM2_LEN	28
+#define	TMK_TVALID		0x40				// init.h
+#define	TMK_RE			0x80
+
+//-----------------------------------------------------------------------------
+// sample() feeds one phase value (input units) taken at time t (s, or NAN)
+//-----------------------------------------------------------------------------
+static void sample(double t, double ph){
+	double	d;
+	double	n;
+
+	if(cfg.wrap > 0.0){
+		if(have_ph){
+			d = ph + ph_off - ph_last;
+			ph_off -= cfg.wrap * floor(d / cfg.wrap + 0.5);
+		}
+		ph += ph_off;
+		ph_last = ph;
+		have_ph = 1;
+	}
+	if(!isnan(t)){
+		if(have_t){
+			n = floor((t - t_next) / cfg.tau0 + 0.5);
+			if(n < 0.0){
+				n_late++;
+				return;
+			}
+			for(; n>0.0; n-=1.0){
+				adev_gap(&eng);
+				n_gap++;
+			}
+			t_next += cfg.tau0 * floor((t - t_next) / cfg.tau0 + 0.5);
+		}else{
+			t_next = t;
+			have_t = 1;
+		}
+		t_next += cfg.tau0;
+	}
+	adev_add(&eng, ph * cfg.scale);
+	n_in++;
+}
+
+//-----------------------------------------------------------------------------
+// read_text() takes column "col" (and "tcol") of each numeric line
+//-----------------------------------------------------------------------------
+static void read_text(FILE* fp){
+	char		line[1024];
+	char*		p;
+	char*		end;
+	double		v;
+	double		t;
+	double		ph;
+	uint32_t	c;
+	int			got;
+
+	while(fgets(line, sizeof(line), fp)){
+		t = NAN;
+		ph = NAN;
+		got = 0;
+		p = line;
+		for(c=1; *p; c++){
+			while((*p == ' ') || (*p == '\t') || (*p == ',')) p++;
+			if(!*p || (*p == '\n') || (*p == '\r')) break;
+			v = strtod(p, &end);
+			if(end == p){
+				if(c == 1) break;				// header or comment
+				v = NAN;
+				while(*end && (*end != ',') && (*end != ' ') && (*end != '\t')) end++;
+			}
+			if(c == cfg.col){
+				ph = v;
+				got++;
+			}
+			if(c == cfg.tcol) t = v;
+			p = end;
+		}
+		if(got && !isnan(ph)) sample(cfg.tcol ? t : NAN, ph);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// read_ubx() scans a receiver capture for TIM-TM2 (B5 62 0D 03, 28 bytes)
+//-----------------------------------------------------------------------------
+static void read_ubx(FILE* fp){
+	static const uint8_t	hdr[4] = { 0xb5, 0x62, 0x0d, 0x03 };
+	uint8_t		f[UBX_TIM_TM2_LEN + 4];		// length, payload, checksum
+	uint8_t		ck_a;
+	uint8_t		ck_b;
+	uint32_t	ms;
+	uint32_t	sub;
+	double		t;
+	int			c;
+	int			h = 0;
+	int			i;
+
+	while((c = getc(fp)) != EOF){
+		if(c != hdr[h]){
+			h = (c == hdr[0]) ? 1 : 0;
+			continue;
+		}
+		if(++h < 4) continue;
+		h = 0;
+		if(fread(f, 1, sizeof(f), fp) != sizeof(f)) break;
+		if((f[0] | (f[1] << 8)) != UBX_TIM_TM2_LEN) continue;
+		ck_a = 0;
+		ck_b = 0;
+		for(i=-2; i<UBX_TIM_TM2_LEN + 2; i++){
+			ck_a += (i < 0) ? hdr[4 + i] : f[i];
+			ck_b += ck_a;
+		}
+		if((ck_a != f[UBX_TIM_TM2_LEN + 2]) || (ck_b != f[UBX_TIM_TM2_LEN + 3])) continue;
+		// payload at f + 2: ch, flags, count, wnR, wnF, towMsR, towSubMsR ...
+		if((f[2] != 0) || ((f[3] & (TMK_TVALID | TMK_RE)) != (TMK_TVALID | TMK_RE))) continue;
+		ms = f[10] | (f[11] << 8) | (f[12] << 16) | ((uint32_t)f[13] << 24);
+		sub = f[14] | (f[15] << 8) | (f[16] << 16) | ((uint32_t)f[17] << 24);
+		t = (double)(f[6] | (f[7] << 8)) * 604800.0 + ms / 1000.0;
+		sample(t, (double)(ms % 1000) * 1e6 + sub);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// set() parses one key=value, returns 0 if OK
+//-----------------------------------------------------------------------------
+static int set(const char* arg){
+	const char*	v = strchr(arg, '=');
+	char*		end;
+	size_t		n;
+
+	if(!v) return -1;
+	n = (size_t)(v++ - arg);
+	if((n == 3) && !strncmp(arg, "fmt", n)){
+		if(!strcmp(v, "ubx")) cfg.ubx = 1;
+		else if(!strcmp(v, "text")) cfg.ubx = 0;
+		else return -1;
+		return 0;
+	}
+	if((n == 4) && !strncmp(arg, "tau0", n)) cfg.tau0 = strtod(v, &end);
+	else if((n == 3) && !strncmp(arg, "col", n)) cfg.col = (uint32_t)strtoul(v, &end, 0);
+	else if((n == 4) && !strncmp(arg, "tcol", n)) cfg.tcol = (uint32_t)strtoul(v, &end, 0);
+	else if((n == 5) && !strncmp(arg, "scale", n)) cfg.scale = strtod(v, &end);
+	else if((n == 4) && !strncmp(arg, "wrap", n)) cfg.wrap = strtod(v, &end);
+	else if((n == 4) && !strncmp(arg, "mmax", n)) cfg.mmax = (uint32_t)strtoul(v, &end, 0);
+	else return -1;
+	return ((end == v) || *end) ? -1 : 0;
+}
+
+static void usage(FILE* fp){
+
+	fprintf(fp, "usage: gpsdo_adev [key=value ...] [file]\n"
+		"  fmt=text|ubx     input format (text)\n"
+		"  tau0=s           sample interval, s (1)\n"
+		"  col=n            phase column, text input (1)\n"
+		"  tcol=n           time column, s (0 = one sample per line)\n"
+		"  scale=x          phase units to seconds (1e-9)\n"
+		"  wrap=x           unwrap modulus in phase units (0 = none)\n"
+		"  mmax=n           largest averaging factor (65536)\n");
+}
+
+//-----------------------------------------------------------------------------
+// main()
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv){
+	adev_point	pt[ADEV_MAX_TAUS];
+	const char*	path = 0;
+	FILE*		fp = stdin;
+	int			n;
+	int			i;
+
+	cfg.tau0 = 1.0;
+	cfg.col = 1;
+	cfg.tcol = 0;
+	cfg.scale = 1e-9;
+	cfg.wrap = 0.0;
+	cfg.mmax = 65536;
+	cfg.ubx = 0;
+	for(i=1; i<argc; i++){
+		if(!strcmp(argv[i], "help")){
+			usage(stdout);
+			return 0;
+		}
+		if(strchr(argv[i], '=')){
+			if(set(argv[i])){
+				fprintf(stderr, "gpsdo_adev: bad parameter \"%s\"\n", argv[i]);
+				usage(stderr);
+				return 1;
+			}
+		}else{
+			path = argv[i];
+		}
+	}
+	if(cfg.ubx && (cfg.wrap == 0.0)) cfg.wrap = 1e9;	// phase is known modulo 1 s
+	if(adev_init(&eng, cfg.tau0, cfg.mmax)){
+		fprintf(stderr, "gpsdo_adev: bad tau0/mmax or out of memory\n");
+		return 1;
+	}
+	if(path){
+		fp = fopen(path, cfg.ubx ? "rb" : "r");
+		if(!fp){
+			fprintf(stderr, "gpsdo_adev: can't open %s\n", path);
+			return 1;
+		}
+	}
+	if(cfg.ubx) read_ubx(fp);
+	else read_text(fp);
+	if(path) fclose(fp);
+	n = adev_result(&eng, pt);
+	printf("# samples %llu  missing %llu  out_of_order %llu  tau0 %g s\n", (unsigned long long)n_in,
+		(unsigned long long)n_gap, (unsigned long long)n_late, cfg.tau0);
+	printf("%12s %12s %12s %12s %12s\n", "tau_s", "n", "adev", "mdev", "tdev_s");
+	for(i=0; i<n; i++){
+		printf("%12g %12llu %12.4e %12.4e %12.4e\n", pt[i].tau, (unsigned long long)pt[i].n,
+			pt[i].adev, pt[i].mdev, pt[i].tdev);
+	}
+	adev_free(&eng);
+	return 0;
+}
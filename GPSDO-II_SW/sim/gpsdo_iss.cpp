@@ -0,0 +1,152 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: gpsdo_iss.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   gpsdo_iss: runs the shipped GPSDO2.hex on the CIP-51
+ *             instruction-set simulator against the gpsdo_sim board, OCXO
+ *             and GPS models, and prints the measured CPU cost of the real
+ *             binary: per-vector ISR latency and length, main loop pass
+ *             length and CPU load.
+ *
+ *             gpsdo_iss [hex=file] [gpsdo_sim key=value ...]
+ *
+ *             The default hex file is ../GPSDO2.hex and the default run is
+ *             one simulated hour (hours=).  Cycle figures are SYSCLK clocks
+ *             at 24.5 MHz.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  gps.capture / gps.replay files
+ *
+ *******************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "c8051F520.h"
+#include "kernel.h"
+#include "sfr.h"
+#include "mcu.h"
+#include "board.h"
+#include "ad5761.h"
+#include "ds1722.h"
+#include "plant.h"
+#include "ublox.h"
+#include "config.h"
+#include "metrics.h"
+#include "cip51.h"
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+#define	HEX_DEFAULT	"../GPSDO2.hex"
+
+static const char* const isr_name[16] = {
+	"int0", "timer0", "int1", "timer1", "uart0", "timer2", "spi0", "adc0_wc",
+	"adc0_eoc", "pca0", "cp_fall", "cp_rise", "lin", "vreg", "port_match", "int15"
+};
+
+static inline double cyc_us(double c){
+	return c * 1e6 / SIM_SYSCLK;
+}
+
+//-----------------------------------------------------------------------------
+// report() prints the CPU figures
+//-----------------------------------------------------------------------------
+static void report(const char* hex){
+	const cip51_stats*		s = &cip51_stat;
+	const cip51_isr_stats*	v;
+	double					total = (double)s->cycles;
+	int						i;
+
+	printf("hex_file           %s\n", hex);
+	printf("sim_hours          %.3f\n", total / SIM_SYSCLK / 3600.0);
+	printf("instructions       %llu\n", (unsigned long long)s->instr);
+	printf("cpu_load_pct       %.4f\n", 100.0 * (total - (double)s->idle) / total);
+	printf("isr_load_pct       %.4f\n", 100.0 * (double)s->isr / total);
+	printf("boot_us            %.1f\n", cyc_us((double)s->boot));
+	printf("main_passes        %llu\n", (unsigned long long)s->passes);
+	printf("main_pass_mean_cyc %.1f\n", s->passes ? (double)s->pass_sum / (double)s->passes : 0.0);
+	printf("main_pass_max_cyc  %u\n", s->pass_max);
+	printf("main_pass_max_us   %.2f\n", cyc_us(s->pass_max));
+	printf("main_span_max_us   %.2f\n", cyc_us(s->pass_span_max));
+	printf("stack_max          0x%02x\n", s->sp_max);
+	printf("bad_opcodes        %u\n", s->bad_ops);
+	printf("dac_writes         %u\n", ad5761_stat.updates);
+	printf("uart_bytes         %u\n", mcu_stat.uart_rx);
+	printf("uart_overruns      %u\n", mcu_stat.uart_overrun);
+	printf("%-10s %10s %9s %9s %9s %9s %9s %9s\n", "isr", "count", "lat_mean", "lat_max", "lat_max_us",
+		"cyc_mean", "cyc_max", "load_pct");
+	for(i=0; i<16; i++){
+		v = &s->vec[i];
+		if(!v->count) continue;
+		printf("%-10s %10u %9.1f %9u %9.2f %9.1f %9u %9.4f\n", isr_name[i], v->count,
+			(double)v->lat_sum / v->count, v->lat_max, cyc_us(v->lat_max),
+			(double)v->cyc_sum / v->count, v->cyc_max, 100.0 * (double)v->cyc_sum / total);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// main()
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv){
+	const char*	hex = HEX_DEFAULT;
+	clock_t		wall;
+	int			i;
+
+	config_defaults();
+	sim_cfg.hours = 1.0;
+	if((argc > 1) && !strcmp(argv[1], "help")){
+		printf("usage: gpsdo_iss [hex=file] [key=value ...]\n");
+		config_usage(stdout);
+		return 0;
+	}
+	for(i=1; i<argc; i++){
+		if(!strncmp(argv[i], "hex=", 4)) hex = argv[i] + 4;
+		else if(config_set(argv[i])){
+			fprintf(stderr, "gpsdo_iss: bad parameter \"%s\"\n", argv[i]);
+			return 1;
+		}
+	}
+	switch(cip51_load(hex)){
+	case HEX_OK:
+		break;
+	case HEX_OPEN:
+		fprintf(stderr, "gpsdo_iss: can't open %s\n", hex);
+		return 1;
+	default:
+		fprintf(stderr, "gpsdo_iss: %s is not a valid F520 image\n", hex);
+		return 1;
+	}
+	if(metrics_init(sim_cfg.hours * 3600.0)){
+		fprintf(stderr, "gpsdo_iss: can't open %s\n", sim_cfg.trace);
+		return 1;
+	}
+	// power-on reset
+	sfr_reset();
+	mcu_init();
+	board_init();
+	plant_init();
+	ad5761_init();
+	ds1722_init();
+	if(ublox_init()){
+		fprintf(stderr, "gpsdo_iss: can't open %s\n", sim_cfg.gps_replay[0] ? sim_cfg.gps_replay : sim_cfg.gps_capture);
+		return 1;
+	}
+	cip51_reset();
+	wall = clock();
+	cip51_run(sim_cycles(sim_cfg.hours * 3600.0L));
+	metrics_done();
+	ublox_done();
+	report(hex);
+	printf("wall_s             %.2f\n", (double)(clock() - wall) / CLOCKS_PER_SEC);
+	return 0;
+}
@@ -0,0 +1,336 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: gpsdo_mc.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   gpsdo_mc: Monte-Carlo runner for gpsdo_sim.  Runs mc.runs
+ *             independent instances, mc.jobs at a time, each with its own
+ *             seed and with the oscillator null, aging, noise levels and
+ *             ambient temperature drawn around the gpsdo_sim parameters.
+ *             Prints the distribution of time-to-VCO_TRACK, steady-state
+ *             phase RMS, DAC writes and holdover time error.
+ *
+ *             Every instance is a forked child of a parent that never runs
+ *             the firmware, so each one starts from the power-on values of
+ *             cflag, gpstimer and the rest of the firmware globals and no
+ *             state is shared between instances.  The child returns its
+ *             result through a pipe.
+ *
+ *             gpsdo_mc [mc.key=value ...] [gpsdo_sim key=value ...]
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <vector>
+#include "config.h"
+#include "metrics.h"
+#include "instance.h"
+#include "ad5761.h"
+#include "rng.h"
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+struct mc_config {
+	uint32_t	runs;						// instances
+	uint32_t	jobs;						// concurrent instances (0 = one per core)
+	double		null;						// osc.null_dac spread, LSB rms
+	double		age;						// osc.age1 spread, per day rms
+	double		noise;						// noise level spread, decades rms
+	double		temp;						// ambient spread, C rms
+	char		csv[CFG_PATH_LEN];			// per-run CSV ("" = none)
+};
+
+static	mc_config	mc;
+
+enum mc_type { MC_DBL, MC_U32, MC_STR };
+
+struct mc_key {
+	const char*	name;
+	mc_type		type;
+	void*		p;
+	const char*	help;
+};
+
+static const mc_key mc_keys[] = {
+	{ "mc.runs",	MC_U32, &mc.runs,	"number of instances" },
+	{ "mc.jobs",	MC_U32, &mc.jobs,	"concurrent instances (0 = one per core)" },
+	{ "mc.null",	MC_DBL, &mc.null,	"osc.null_dac spread, LSB rms" },
+	{ "mc.age",		MC_DBL, &mc.age,	"osc.age1 spread, per day rms" },
+	{ "mc.noise",	MC_DBL, &mc.noise,	"osc noise level spread, decades rms" },
+	{ "mc.temp",	MC_DBL, &mc.temp,	"ambient temperature spread, C rms" },
+	{ "mc.csv",		MC_STR, mc.csv,		"per-run CSV file" },
+};
+
+#define	NUM_MC_KEYS	(sizeof(mc_keys) / sizeof(mc_keys[0]))
+
+// what a child sends back
+struct mc_result {
+	int			status;						// INST_x, -1 = child died
+	uint32_t	seed;
+	double		null_dac;					// drawn parameters
+	double		age1;
+	double		noise_k;
+	double		temp;
+	int			mode;						// final loop mode
+	double		t_track;
+	double		phase_rms;
+	double		holdover_err;
+	uint32_t	dac_writes;
+};
+
+// a running child
+struct mc_child {
+	pid_t		pid;
+	int			fd;
+	uint32_t	run;
+};
+
+//-----------------------------------------------------------------------------
+// mc_set() parses one mc.key=value, returns 0 if OK
+//-----------------------------------------------------------------------------
+static int mc_set(const char* arg){
+	const char*	eq = strchr(arg, '=');
+	char*		end;
+	size_t		i;
+
+	if(!eq) return -1;
+	for(i=0; i<NUM_MC_KEYS; i++){
+		if((strlen(mc_keys[i].name) == (size_t)(eq - arg)) && !strncmp(mc_keys[i].name, arg, eq - arg)) break;
+	}
+	if(i == NUM_MC_KEYS) return -1;
+	switch(mc_keys[i].type){
+	case MC_DBL:
+		*(double*)mc_keys[i].p = strtod(eq + 1, &end);
+		break;
+	case MC_U32:
+		*(uint32_t*)mc_keys[i].p = (uint32_t)strtoul(eq + 1, &end, 0);
+		break;
+	default:
+		if(strlen(eq + 1) >= CFG_PATH_LEN) return -1;
+		strcpy((char*)mc_keys[i].p, eq + 1);
+		return 0;
+	}
+	return ((end == eq + 1) || *end) ? -1 : 0;
+}
+
+static void mc_usage(FILE* fp){
+	size_t	i;
+
+	fprintf(fp, "usage: gpsdo_mc [mc.key=value ...] [gpsdo_sim key=value ...]\n");
+	for(i=0; i<NUM_MC_KEYS; i++){
+		fprintf(fp, "  %-16s %s\n", mc_keys[i].name, mc_keys[i].help);
+	}
+	config_usage(fp);
+}
+
+//-----------------------------------------------------------------------------
+// mc_draw() sets up sim_cfg for run "run".  The draws come from the run's own
+//	stream, so a run gives the same result whatever mc.runs and mc.jobs are.
+//-----------------------------------------------------------------------------
+static void mc_draw(const sim_config* base, uint32_t run, mc_result* r){
+	sim_rng	rng;
+
+	sim_cfg = *base;
+	sim_cfg.seed = base->seed + run;
+	sim_cfg.trace[0] = '\0';
+	rng_seed(&rng, sim_cfg.seed, RNG_MC);
+	sim_cfg.osc_null_dac += mc.null * rng_gauss(&rng);
+	if(sim_cfg.osc_null_dac < 0.0) sim_cfg.osc_null_dac = 0.0;
+	if(sim_cfg.osc_null_dac > 65535.0) sim_cfg.osc_null_dac = 65535.0;
+	sim_cfg.osc_age1 += mc.age * rng_gauss(&rng);
+	r->noise_k = pow(10.0, mc.noise * rng_gauss(&rng));
+	sim_cfg.osc_wfm *= r->noise_k;
+	sim_cfg.osc_ffm *= r->noise_k;
+	sim_cfg.osc_rwfm *= r->noise_k;
+	sim_cfg.temp += mc.temp * rng_gauss(&rng);
+	r->seed = sim_cfg.seed;
+	r->null_dac = sim_cfg.osc_null_dac;
+	r->age1 = sim_cfg.osc_age1;
+	r->temp = sim_cfg.temp;
+}
+
+//-----------------------------------------------------------------------------
+// mc_spawn() starts run "run" in a child, returns 0 if OK
+//-----------------------------------------------------------------------------
+static int mc_spawn(const sim_config* base, uint32_t run, mc_child* c){
+	int			fd[2];
+	mc_result	r;
+
+	if(pipe(fd)) return -1;
+	fflush(stdout);
+	fflush(stderr);
+	c->pid = fork();
+	if(c->pid < 0){
+		close(fd[0]);
+		close(fd[1]);
+		return -1;
+	}
+	if(c->pid == 0){
+		close(fd[0]);
+		memset(&r, 0, sizeof(r));
+		mc_draw(base, run, &r);
+		r.status = sim_instance();
+		r.mode = metrics_mode();
+		r.t_track = sim_metric.t_track;
+		r.phase_rms = sim_metric.phase_rms;
+		r.holdover_err = sim_metric.holdover_err;
+		r.dac_writes = ad5761_stat.updates;
+		_exit((write(fd[1], &r, sizeof(r)) == (ssize_t)sizeof(r)) ? 0 : 1);
+	}
+	close(fd[1]);
+	c->fd = fd[0];
+	c->run = run;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// mc_stat() prints one line of the distribution table
+//-----------------------------------------------------------------------------
+static double pctl(const std::vector<double>& v, double p){
+	return v[(size_t)(p * (v.size() - 1) + 0.5)];
+}
+
+static void mc_stat(const char* name, std::vector<double> v){
+	double	s = 0.0;
+	double	ss = 0.0;
+	double	m;
+
+	if(v.empty()){
+		printf("%-18s %6u\n", name, 0u);
+		return;
+	}
+	std::sort(v.begin(), v.end());
+	for(double x : v){
+		s += x;
+		ss += x * x;
+	}
+	m = s / v.size();
+	printf("%-18s %6zu %11.4g %11.4g %11.4g %11.4g %11.4g %11.4g %11.4g\n", name, v.size(),
+		m, sqrt(fmax(ss / v.size() - m * m, 0.0)), v.front(), pctl(v, 0.1), pctl(v, 0.5), pctl(v, 0.9), v.back());
+}
+
+//-----------------------------------------------------------------------------
+// main()
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv){
+	static const char* const mode_name[] = { "init", "aqs", "track", "dr" };
+	std::vector<mc_result>	res;
+	std::vector<mc_child>	kids;
+	std::vector<double>		t_track, phase_rms, dac_writes, holdover;
+	sim_config				base;
+	uint32_t				next = 0;
+	uint32_t				failed = 0;
+	uint32_t				modes[4] = { 0, 0, 0, 0 };
+	mc_child				c;
+	mc_result				r;
+	pid_t					pid;
+	int						st;
+	size_t					i;
+	FILE*					csv = 0;
+
+	config_defaults();
+	memset(&mc, 0, sizeof(mc));
+	mc.runs = 100;
+	mc.null = 1000.0;
+	mc.age = 5e-11;
+	mc.noise = 0.2;
+	mc.temp = 5.0;
+	if((argc > 1) && !strcmp(argv[1], "help")){
+		mc_usage(stdout);
+		return 0;
+	}
+	for(st=1; st<argc; st++){
+		if(strncmp(argv[st], "mc.", 3) ? config_set(argv[st]) : mc_set(argv[st])){
+			fprintf(stderr, "gpsdo_mc: bad parameter \"%s\"\n", argv[st]);
+			mc_usage(stderr);
+			return 1;
+		}
+	}
+	if(mc.jobs == 0) mc.jobs = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+	if(mc.jobs == 0) mc.jobs = 1;
+	if(mc.csv[0]){
+		csv = fopen(mc.csv, "w");
+		if(!csv){
+			fprintf(stderr, "gpsdo_mc: can't open %s\n", mc.csv);
+			return 1;
+		}
+		fprintf(csv, "seed,null_dac,age1,noise_k,temp_c,status,mode,t_track_s,phase_rms_ns,holdover_err_ns,dac_writes\n");
+	}
+	base = sim_cfg;
+	res.resize(mc.runs);
+	while((next < mc.runs) || !kids.empty()){
+		while((next < mc.runs) && (kids.size() < mc.jobs)){
+			if(mc_spawn(&base, next, &c)){
+				perror("gpsdo_mc");
+				if(kids.empty()) return 1;
+				break;
+			}
+			kids.push_back(c);
+			next++;
+		}
+		pid = waitpid(-1, &st, 0);
+		if(pid < 0){
+			perror("gpsdo_mc");
+			return 1;
+		}
+		for(i=0; (i < kids.size()) && (kids[i].pid != pid); i++);
+		if(i == kids.size()) continue;
+		memset(&r, 0, sizeof(r));
+		if(!WIFEXITED(st) || WEXITSTATUS(st) || (read(kids[i].fd, &r, sizeof(r)) != (ssize_t)sizeof(r))){
+			r.status = -1;
+			r.seed = base.seed + kids[i].run;
+		}
+		close(kids[i].fd);
+		res[kids[i].run] = r;
+		kids.erase(kids.begin() + i);
+	}
+	// collect in run order
+	for(const mc_result& x : res){
+		if(csv){
+			fprintf(csv, "%u,%.1f,%.4e,%.4f,%.3f,%d,%s,%.1f,%.3f,%.3f,%u\n", x.seed, x.null_dac, x.age1, x.noise_k, x.temp,
+				x.status, mode_name[x.status ? 0 : x.mode], x.t_track, x.phase_rms, x.holdover_err, x.dac_writes);
+		}
+		if(x.status){
+			failed++;
+			continue;
+		}
+		modes[x.mode]++;
+		if(x.t_track >= 0.0) t_track.push_back(x.t_track);
+		phase_rms.push_back(x.phase_rms);
+		dac_writes.push_back(x.dac_writes);
+		if(!std::isnan(x.holdover_err)) holdover.push_back(fabs(x.holdover_err));
+	}
+	if(csv) fclose(csv);
+	printf("runs               %u\n", mc.runs);
+	printf("jobs               %u\n", mc.jobs);
+	printf("sim_hours          %.3f\n", base.hours);
+	printf("failed             %u\n", failed);
+	printf("never_tracked      %zu\n", mc.runs - failed - t_track.size());
+	printf("final_track        %u\n", modes[MODE_TRACK]);
+	printf("final_dr           %u\n", modes[MODE_DR]);
+	printf("final_aqs          %u\n", modes[MODE_AQS]);
+	printf("final_init         %u\n", modes[MODE_INIT]);
+	printf("%-18s %6s %11s %11s %11s %11s %11s %11s %11s\n", "metric", "n", "mean", "sd", "min", "p10", "p50", "p90", "max");
+	mc_stat("time_to_track_s", t_track);
+	mc_stat("ss_phase_rms_ns", phase_rms);
+	mc_stat("dac_writes", dac_writes);
+	mc_stat("holdover_abs_ns", holdover);
+	return failed ? 2 : 0;
+}
@@ -0,0 +1,340 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: gpsdo_regress.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   gpsdo_regress: runs the golden scenarios (cold start with an
+ *             erased dac_save, warm start from a saved DAC off the null
+ *             and off the firmware default, 1 hour GPS loss, ambient
+ *             temperature step, a 5 ns accEst receiver with half an hour
+ *             of degraded timing and glitched marks, one TIM-TM2 in five
+ *             lost) in parallel and checks each metric against the baseline file.  A
+ *             metric that is worse than its baseline by more than its
+ *             tolerance fails the run (exit code 3).
+ *
+ *             gpsdo_regress [golden=file] [update=1] [jobs=n] [gpsdo_sim key=value ...]
+ *
+ *             Baseline lines are "scenario metric value tol_abs tol_rel";
+ *             the limit is value + max(tol_abs, tol_rel * |value|).  All of
+ *             the metrics are smaller-is-better.  update=1 rewrites the file
+ *             with the values of this run and keeps the tolerances.
+ *
+ *             gpsdo_sim keys on the command line apply to every scenario
+ *             (ahead of the scenario's own keys), e.g. fw.kp= to check a loop
+ *             change against the baseline.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  warm_start preloads 33500 (34150 is the empty-flash default, the
+ *                   same run as cold_start)
+ *    10-17-26 jmh:  ss_phase_rms_ns and dac_excursion tolerances 0.5 ns and 3 LSB
+ *    10-17-26 jmh:  low_acc (gps.acc=5, the PCA-fused marks against a tight accEst)
+ *    10-17-26 jmh:  gps_drop (gps.drop=0.2, lost TIM-TM2 frames must not end TRACK)
+ *    10-17-26 jmh:  flash_writes dropped (no scenario writes flash); low_acc adds degraded
+ *                   timing and glitches so the accEst checks reject marks
+ *
+ *******************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <vector>
+#include "config.h"
+#include "metrics.h"
+#include "instance.h"
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+#define	GOLDEN_DEFAULT	"golden.txt"
+#define	NAME_LEN		32
+
+struct scenario {
+	const char*	name;
+	const char*	keys[8];					// gpsdo_sim keys (0 = end)
+};
+
+static const scenario scenarios[] = {
+	{ "cold_start",	{ "hours=6", "flash.dac=-1", 0 } },
+	{ "warm_start",	{ "hours=6", "flash.dac=33500", 0 } },
+	{ "gps_loss",	{ "hours=6", "gps.loss_at=7200", "gps.loss_len=3600", 0 } },
+	{ "temp_step",	{ "hours=6", "temp.step_at=10800", "temp.step=10", 0 } },
+	{ "low_acc",	{ "hours=6", "gps.acc=5", "gps.deg_at=10800", "gps.deg_len=1800", "gps.deg_acc=100",
+					  "gps.glitch=0.01", 0 } },
+	{ "gps_drop",	{ "hours=6", "gps.drop=0.2", 0 } },
+};
+
+#define	NUM_SCEN	(int)(sizeof(scenarios) / sizeof(scenarios[0]))
+
+enum { M_TRACK, M_PHASE, M_DAC, NUM_MET };
+
+struct metric {
+	const char*	name;
+	double		tol_abs;					// default tolerances for a new baseline
+	double		tol_rel;
+};
+
+static const metric metrics[NUM_MET] = {
+	{ "time_to_track_s",	5.0,	0.10 },
+	{ "ss_phase_rms_ns",	0.5,	0.10 },
+	{ "dac_excursion",		3.0,	0.10 },
+};
+
+// what a child sends back
+struct reg_result {
+	int			status;						// INST_x, -1 = child died
+	double		v[NUM_MET];
+};
+
+struct reg_child {
+	pid_t		pid;
+	int			fd;
+	int			scen;
+};
+
+struct baseline {
+	char		scen[NAME_LEN];
+	char		met[NAME_LEN];
+	double		value;
+	double		tol_abs;
+	double		tol_rel;
+	int			seen;						// matched by this run
+};
+
+//-----------------------------------------------------------------------------
+// run_scenario() is the child side
+//-----------------------------------------------------------------------------
+static void run_scenario(const sim_config* base, int s, reg_result* r){
+	int	i;
+
+	sim_cfg = *base;
+	sim_cfg.trace[0] = '\0';
+	for(i=0; scenarios[s].keys[i]; i++){
+		if(config_set(scenarios[s].keys[i])){
+			r->status = -1;
+			return;
+		}
+	}
+	r->status = sim_instance();
+	// a loop that never tracks is as bad as it gets
+	r->v[M_TRACK] = (sim_metric.t_track < 0.0) ? HUGE_VAL : sim_metric.t_track;
+	r->v[M_PHASE] = sim_metric.phase_rms;
+	r->v[M_DAC] = (sim_metric.t_track < 0.0) ? HUGE_VAL : (double)(sim_metric.dac_hi - sim_metric.dac_lo);
+}
+
+static int spawn(const sim_config* base, int s, reg_child* c){
+	int			fd[2];
+	reg_result	r;
+
+	if(pipe(fd)) return -1;
+	fflush(stdout);
+	fflush(stderr);
+	c->pid = fork();
+	if(c->pid < 0){
+		close(fd[0]);
+		close(fd[1]);
+		return -1;
+	}
+	if(c->pid == 0){
+		close(fd[0]);
+		memset(&r, 0, sizeof(r));
+		run_scenario(base, s, &r);
+		_exit((write(fd[1], &r, sizeof(r)) == (ssize_t)sizeof(r)) ? 0 : 1);
+	}
+	close(fd[1]);
+	c->fd = fd[0];
+	c->scen = s;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// load_golden() reads the baseline file, returns -1 if it can't be opened
+//-----------------------------------------------------------------------------
+static int load_golden(const char* path, std::vector<baseline>& g){
+	FILE*		fp = fopen(path, "r");
+	char		line[256];
+	baseline	b;
+
+	if(!fp) return -1;
+	while(fgets(line, sizeof(line), fp)){
+		memset(&b, 0, sizeof(b));
+		if((line[0] == '#') || (sscanf(line, "%31s %31s %lf %lf %lf", b.scen, b.met, &b.value, &b.tol_abs,
+			&b.tol_rel) != 5)) continue;
+		g.push_back(b);
+	}
+	fclose(fp);
+	return 0;
+}
+
+static baseline* find(std::vector<baseline>& g, const char* scen, const char* met){
+	size_t	i;
+
+	for(i=0; i<g.size(); i++){
+		if(!strcmp(g[i].scen, scen) && !strcmp(g[i].met, met)) return &g[i];
+	}
+	return 0;
+}
+
+static int save_golden(const char* path, const std::vector<baseline>& g, const sim_config* base){
+	FILE*	fp = fopen(path, "w");
+	size_t	i;
+
+	if(!fp) return -1;
+	fprintf(fp, "# gpsdo_regress baseline, seed %u (update=1 rewrites the values, keeps the tolerances)\n",
+		base->seed);
+	fprintf(fp, "# scenario       metric                        value   tol_abs   tol_rel\n");
+	for(i=0; i<g.size(); i++){
+		fprintf(fp, "%-16s %-18s %16.10g %9g %9g\n", g[i].scen, g[i].met, g[i].value, g[i].tol_abs, g[i].tol_rel);
+	}
+	fclose(fp);
+	return 0;
+}
+
+static void usage(FILE* fp){
+
+	fprintf(fp, "usage: gpsdo_regress [golden=file] [update=1] [jobs=n] [gpsdo_sim key=value ...]\n");
+	config_usage(fp);
+}
+
+//-----------------------------------------------------------------------------
+// main()
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv){
+	std::vector<baseline>	golden;
+	std::vector<reg_child>	kids;
+	reg_result				res[NUM_SCEN];
+	const char*				path = GOLDEN_DEFAULT;
+	sim_config				base;
+	baseline				nb;
+	baseline*				b;
+	reg_child				c;
+	reg_result				r;
+	unsigned				jobs = 0;
+	int						update = 0;
+	int						failed = 0;
+	int						next = 0;
+	int						s;
+	int						m;
+	double					lim;
+	pid_t					pid;
+	int						st;
+	size_t					i;
+
+	config_defaults();
+	for(s=1; s<argc; s++){
+		if(!strcmp(argv[s], "help")){
+			usage(stdout);
+			return 0;
+		}
+		if(!strncmp(argv[s], "golden=", 7)) path = argv[s] + 7;
+		else if(!strncmp(argv[s], "update=", 7)) update = atoi(argv[s] + 7);
+		else if(!strncmp(argv[s], "jobs=", 5)) jobs = (unsigned)atoi(argv[s] + 5);
+		else if(config_set(argv[s])){
+			fprintf(stderr, "gpsdo_regress: bad parameter \"%s\"\n", argv[s]);
+			usage(stderr);
+			return 1;
+		}
+	}
+	if(load_golden(path, golden) && !update){
+		fprintf(stderr, "gpsdo_regress: can't open %s (update=1 creates it)\n", path);
+		return 1;
+	}
+	if(jobs == 0) jobs = (unsigned)sysconf(_SC_NPROCESSORS_ONLN);
+	if(jobs == 0) jobs = 1;
+	base = sim_cfg;
+	while((next < NUM_SCEN) || !kids.empty()){
+		while((next < NUM_SCEN) && (kids.size() < jobs)){
+			if(spawn(&base, next, &c)){
+				perror("gpsdo_regress");
+				if(kids.empty()) return 1;
+				break;
+			}
+			kids.push_back(c);
+			next++;
+		}
+		pid = waitpid(-1, &st, 0);
+		if(pid < 0){
+			perror("gpsdo_regress");
+			return 1;
+		}
+		for(i=0; (i < kids.size()) && (kids[i].pid != pid); i++);
+		if(i == kids.size()) continue;
+		memset(&r, 0, sizeof(r));
+		if(!WIFEXITED(st) || WEXITSTATUS(st) || (read(kids[i].fd, &r, sizeof(r)) != (ssize_t)sizeof(r))){
+			r.status = -1;
+		}
+		close(kids[i].fd);
+		res[kids[i].scen] = r;
+		kids.erase(kids.begin() + i);
+	}
+	// compare (or re-baseline)
+	printf("%-12s %-16s %12s %12s %12s %12s  %s\n", "scenario", "metric", "baseline", "value", "limit", "diff", "result");
+	for(s=0; s<NUM_SCEN; s++){
+		if(res[s].status){
+			printf("%-12s %-16s %12s %12s %12s %12s  FAILED (run status %d)\n", scenarios[s].name, "-", "-", "-", "-",
+				"-", res[s].status);
+			failed++;
+			continue;
+		}
+		for(m=0; m<NUM_MET; m++){
+			b = find(golden, scenarios[s].name, metrics[m].name);
+			if(update){
+				if(!b){
+					memset(&nb, 0, sizeof(nb));
+					strcpy(nb.scen, scenarios[s].name);
+					strcpy(nb.met, metrics[m].name);
+					nb.tol_abs = metrics[m].tol_abs;
+					nb.tol_rel = metrics[m].tol_rel;
+					golden.push_back(nb);
+					b = &golden.back();
+				}
+				b->value = res[s].v[m];
+				b->seen = 1;
+				printf("%-12s %-16s %12s %12.6g %12s %12s  baseline\n", scenarios[s].name, metrics[m].name, "-",
+					res[s].v[m], "-", "-");
+				continue;
+			}
+			if(!b){
+				printf("%-12s %-16s %12s %12.6g %12s %12s  NO BASELINE\n", scenarios[s].name, metrics[m].name, "-",
+					res[s].v[m], "-", "-");
+				failed++;
+				continue;
+			}
+			b->seen = 1;
+			lim = b->value + fmax(b->tol_abs, b->tol_rel * fabs(b->value));
+			if(isinf(b->value)) lim = HUGE_VAL;
+			printf("%-12s %-16s %12.6g %12.6g %12.6g %+12.6g  %s\n", scenarios[s].name, metrics[m].name, b->value,
+				res[s].v[m], lim, isinf(res[s].v[m]) ? HUGE_VAL : res[s].v[m] - b->value,
+				(res[s].v[m] > lim) ? "REGRESSED" : (res[s].v[m] < b->value - fmax(b->tol_abs, b->tol_rel * fabs(b->value)))
+				? "improved (update=1 to re-baseline)" : "ok");
+			if(res[s].v[m] > lim) failed++;
+		}
+	}
+	if(update){
+		if(failed){
+			fprintf(stderr, "gpsdo_regress: not updating %s, %d scenario(s) failed to run\n", path, failed);
+			return 1;
+		}
+		if(save_golden(path, golden, &base)){
+			fprintf(stderr, "gpsdo_regress: can't write %s\n", path);
+			return 1;
+		}
+		printf("baseline written to %s\n", path);
+		return 0;
+	}
+	for(i=0; i<golden.size(); i++){
+		if(!golden[i].seen) printf("note: baseline %s %s has no scenario\n", golden[i].scen, golden[i].met);
+	}
+	printf("%s: %d regression(s)\n", failed ? "FAIL" : "PASS", failed);
+	return failed ? 3 : 0;
+}
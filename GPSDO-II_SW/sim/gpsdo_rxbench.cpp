@@ -0,0 +1,436 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: gpsdo_rxbench.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   gpsdo_rxbench: replays a receiver capture through the UBX
+ *             receive path (rxd_intr() and getm() in serial.c) and accounts
+ *             for every TIM-TM2 frame in it.
+ *
+ *             gpsdo_rxbench [poll=s] [hex=file [isr_max=cycles]] file
+ *
+ *             The capture is a raw UART byte stream (a recording of the
+ *             receiver, or gpsdo_sim gps.capture=) and is played back to
+ *             back at 38400 baud, i.e. as one continuous burst.  getm() is
+ *             called the way the main loop calls it: after every byte
+ *             (poll=0, the loop wakes on each interrupt) or every poll=
+ *             seconds to model a busy main loop, whenever a frame slot is
+ *             full.  One getm() call empties every full slot, as one main
+ *             loop pass does.
+ *
+ *             Every TIM-TM2 in the capture with a good checksum ends up as:
+ *
+ *               accepted    buffered, checksum good, passed to getm()
+ *               busy        its header arrived while the TIM-TM2 slot was
+ *                           still waiting for getm()
+ *               swallowed   its header went by while rxd_intr() was still
+ *                           counting off the frame before it
+ *               overrun     not the length of its ubx_tab[] entry, dropped
+ *               bad_check   buffered, but failed the rxd_intr() checksum
+ *               missed      prefix not recognized for any other reason
+ *
+ *             The per-byte ISR cost is measured two ways: host time of the
+ *             native rxd_intr() (relative figures, for comparing parser
+ *             changes), and with hex= the CIP-51 cycle count of the UART ISR
+ *             of that image running against the same capture (gps.replay) on
+ *             the instruction-set simulator.  With isr_max= the run fails
+ *             (exit code 3) if the longest UART ISR of the image is over it.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  checksum failures are found by rxd_intr()
+ *    10-17-26 jmh:  frame slots; fates from the rxd_intr() drop counters
+ *    10-17-26 jmh:  table-driven framing: fates follow rxd_st, getm() drains several slots
+ *    10-17-26 jmh:  isr_max= (UART ISR cycle budget)
+ *    10-17-26 jmh:  TIM-TM2 slot of its own (rxd_tm2f), TIM-TP/NAV-STATUS share one; U16 accEst
+ *
+ *******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "c8051F520.h"
+#include "kernel.h"
+#include "sfr.h"
+#include "mcu.h"
+#include "board.h"
+#include "ad5761.h"
+#include "ds1722.h"
+#include "plant.h"
+#include "ublox.h"
+#include "config.h"
+#include "metrics.h"
+#include "cip51.h"
+
+//------------------------------------------------------------------------------
+// firmware (serial.c, compiled by the sim build)
+//------------------------------------------------------------------------------
+
+void init_serial(void);
+void rxd_intr(void);
+unsigned char getm(unsigned int* rslt, unsigned short* accuracy, unsigned char cmd);
+
+extern bool rxd_tm2f;
+extern bool rxd_tpf;
+extern bool rxd_statf;
+extern unsigned char rxd_st;
+extern unsigned short rxd_novr;
+extern unsigned short rxd_novf;
+extern unsigned short rxd_nck;
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+#define	BAUD			38400.0
+#define	TM2_FRAME		36					// sync, class/id, length, 28 payload, checksum
+#define	RX_SYNC1		0					// serial.c rxd_st
+#define	RX_ID			3
+#define	RX_PAY			6
+#define	RX_SKIP			7
+
+enum rx_fate { FATE_NONE, FATE_ACCEPTED, FATE_BUSY, FATE_SWALLOWED, FATE_OVERRUN, FATE_BAD_CHECK,
+	FATE_MISSED, NUM_FATE };
+
+static const char* const fate_name[NUM_FATE] = { "pending", "accepted", "busy", "swallowed", "overrun",
+	"bad_check", "missed" };
+
+struct rx_frame {
+	uint32_t	id_at;						// offset of the ID byte (end of the prefix)
+	int			fate;
+};
+
+struct rx_scan {
+	uint32_t	ubx;						// UBX frames with a good checksum
+	uint32_t	ubx_bad;					// UBX headers with a bad checksum or length
+	uint32_t	nmea;						// NMEA sentences
+	uint32_t	tm2;						// TIM-TM2 frames, good checksum
+	uint32_t	burst_max;					// longest run of bytes without a TIM-TM2, bytes
+};
+
+static	uint8_t*	cap;
+static	uint32_t	cap_len;
+static	rx_frame*	frames;
+static	uint32_t	nframes;
+static	int32_t*	frame_at;				// by offset: index of the TIM-TM2 whose ID byte it is, or -1
+static	rx_scan		scan;
+static	double		poll;					// getm() interval, s (0 = after every byte)
+static	const char*	hex;
+static	uint32_t	isr_max;				// UART ISR budget, cycles (0 = none)
+
+//-----------------------------------------------------------------------------
+// load() reads the whole capture, returns 0 if OK
+//-----------------------------------------------------------------------------
+static int load(const char* path){
+	FILE*	fp = fopen(path, "rb");
+	long	n;
+
+	if(!fp) return -1;
+	fseek(fp, 0, SEEK_END);
+	n = ftell(fp);
+	rewind(fp);
+	cap = (uint8_t*)malloc(n > 0 ? (size_t)n : 1);
+	if(!cap || (n <= 0) || (fread(cap, 1, (size_t)n, fp) != (size_t)n)){
+		fclose(fp);
+		return -1;
+	}
+	fclose(fp);
+	cap_len = (uint32_t)n;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// scan_capture() finds the ground truth: every well-formed UBX frame and
+//	NMEA sentence, and the TIM-TM2 frames the firmware should catch
+//-----------------------------------------------------------------------------
+static void scan_capture(void){
+	uint32_t	i = 0;
+	uint32_t	len;
+	uint32_t	j;
+	uint32_t	last = 0;
+	uint8_t		ck_a;
+	uint8_t		ck_b;
+
+	frames = (rx_frame*)calloc(cap_len / TM2_FRAME + 1, sizeof(rx_frame));
+	frame_at = (int32_t*)malloc(cap_len * sizeof(int32_t));
+	memset(frame_at, 0xff, cap_len * sizeof(int32_t));
+	while(i < cap_len){
+		if((cap[i] == '$') && (i + 1 < cap_len) && (cap[i + 1] == 'G')){
+			scan.nmea++;
+			i++;
+			continue;
+		}
+		if((cap[i] != 0xb5) || (i + 8 > cap_len) || (cap[i + 1] != 0x62)){
+			i++;
+			continue;
+		}
+		len = cap[i + 4] | (cap[i + 5] << 8);
+		if(i + 8 + len > cap_len){
+			scan.ubx_bad++;
+			i++;
+			continue;
+		}
+		ck_a = 0;
+		ck_b = 0;
+		for(j=i+2; j<i+6+len; j++){
+			ck_a += cap[j];
+			ck_b += ck_a;
+		}
+		if((ck_a != cap[i + 6 + len]) || (ck_b != cap[i + 7 + len])){
+			scan.ubx_bad++;
+			i++;
+			continue;
+		}
+		scan.ubx++;
+		if((cap[i + 2] == 0x0d) && (cap[i + 3] == 0x03) && (len == 28)){
+			if(i - last > scan.burst_max) scan.burst_max = i - last;
+			last = i + TM2_FRAME;
+			frame_at[i + 3] = (int32_t)nframes;
+			frames[nframes].id_at = i + 3;
+			frames[nframes].fate = FATE_NONE;
+			nframes++;
+			scan.tm2++;
+		}
+		i += 8 + len;
+	}
+	if(cap_len - last > scan.burst_max) scan.burst_max = cap_len - last;
+}
+
+//-----------------------------------------------------------------------------
+// replay() feeds the capture to rxd_intr() and calls getm() as the main loop
+//	would, and gives every TIM-TM2 its fate
+//-----------------------------------------------------------------------------
+static void replay(uint32_t* getm_rtrn){
+	unsigned int	tt;
+	unsigned short	aa;
+	double			t_byte = 10.0 / BAUD;
+	double			t_poll = 0.0;
+	int32_t			cur = -1;				// TIM-TM2 being framed (-1 = none / another message)
+	int32_t			held = -1;				// TIM-TM2 in its slot, waiting for getm()
+	unsigned		was_st;
+	bool			was_tm2f;
+	unsigned		was_ovr;
+	unsigned		was_ovf;
+	unsigned		was_nck;
+	int32_t			f;
+	uint32_t		i;
+	unsigned char	r;
+
+	sim_reset();
+	sfr_reset();
+	mcu_init();
+	SCON0 = 0x10;							// REN0
+	init_serial();
+	getm(&tt, &aa, 1);
+	for(i=0; i<cap_len; i++){
+		was_st = rxd_st;
+		was_tm2f = rxd_tm2f;
+		was_ovr = rxd_novr;
+		was_ovf = rxd_novf;
+		was_nck = rxd_nck;
+		mcu_uart_rx(cap[i]);
+		rxd_intr();
+		f = frame_at[i];
+		if(f >= 0){							// ID byte of a TIM-TM2
+			if(was_st == RX_ID){
+				cur = f;					// in step with the frame
+			}else{
+				frames[f].fate = ((was_st == RX_PAY) || (was_st == RX_SKIP)) ? FATE_SWALLOWED : FATE_MISSED;
+			}
+		}
+		if(rxd_tm2f && !was_tm2f){			// the TIM-TM2 slot filled
+			held = cur;
+			cur = -1;
+		}else if(cur >= 0){
+			if(rxd_novr != was_ovr) frames[cur].fate = FATE_BUSY;
+			else if(rxd_novf != was_ovf) frames[cur].fate = FATE_OVERRUN;
+			else if(rxd_nck != was_nck) frames[cur].fate = FATE_BAD_CHECK;
+			else if(rxd_st == RX_SYNC1) frames[cur].fate = FATE_MISSED;
+			if(frames[cur].fate != FATE_NONE) cur = -1;
+		}
+		if(!rxd_tm2f && !rxd_tpf && !rxd_statf) continue;
+		if((poll > 0.0) && ((i + 1) * t_byte < t_poll)) continue;
+		t_poll += poll;
+		was_tm2f = rxd_tm2f;
+		r = getm(&tt, &aa, 0);
+		if(was_tm2f){						// it took the TIM-TM2
+			if(held >= 0) frames[held].fate = FATE_ACCEPTED;
+			held = -1;
+			getm_rtrn[r < 8 ? r : 7]++;
+		}
+	}
+	if(rxd_tm2f){							// the main loop gets to the last one
+		r = getm(&tt, &aa, 0);
+		if(held >= 0) frames[held].fate = FATE_ACCEPTED;
+		getm_rtrn[r < 8 ? r : 7]++;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// host_cost() times the native rxd_intr() over the capture, ns per byte
+//-----------------------------------------------------------------------------
+static double host_cost(void){
+	clock_t		t0;
+	clock_t		t;
+	unsigned	reps = 0;
+	uint32_t	i;
+
+	t0 = clock();
+	do{
+		SCON0 = 0x10;
+		init_serial();
+		for(i=0; i<cap_len; i++){
+			mcu_uart_rx(cap[i]);
+			rxd_intr();
+			rxd_tm2f = 0;					// getm() without the handlers
+			rxd_tpf = 0;
+			rxd_statf = 0;
+		}
+		reps++;
+		t = clock();
+	}while((t - t0) < CLOCKS_PER_SEC / 5);
+	return (double)(t - t0) / CLOCKS_PER_SEC * 1e9 / ((double)reps * cap_len);
+}
+
+//-----------------------------------------------------------------------------
+// iss_cost() runs the capture against the hex image, returns 0 if OK
+//-----------------------------------------------------------------------------
+static int iss_cost(const char* path){
+	const cip51_isr_stats*	v = &cip51_stat.vec[INTERRUPT_UART0];
+
+	switch(cip51_load(hex)){
+	case HEX_OK:
+		break;
+	case HEX_OPEN:
+		fprintf(stderr, "gpsdo_rxbench: can't open %s\n", hex);
+		return -1;
+	default:
+		fprintf(stderr, "gpsdo_rxbench: %s is not a valid F520 image\n", hex);
+		return -1;
+	}
+	strcpy(sim_cfg.gps_replay, path);
+	sim_cfg.trace[0] = '\0';
+	if(metrics_init(cap_len * 10.0 / BAUD + 1.0)) return -1;
+	sim_reset();
+	sfr_reset();
+	mcu_init();
+	board_init();
+	plant_init();
+	ad5761_init();
+	ds1722_init();
+	if(ublox_init()){
+		fprintf(stderr, "gpsdo_rxbench: can't open %s\n", path);
+		return -1;
+	}
+	cip51_reset();
+	cip51_run(sim_cycles(cap_len * 10.0L / BAUD + 1.0L));
+	metrics_done();
+	ublox_done();
+	printf("iss_hex              %s\n", hex);
+	printf("iss_uart_bytes       %u\n", mcu_stat.uart_rx);
+	printf("iss_uart_overruns    %u\n", mcu_stat.uart_overrun);
+	printf("iss_isr_entries      %u\n", v->count);
+	printf("iss_cyc_per_byte     %.2f\n", mcu_stat.uart_rx ? (double)v->cyc_sum / mcu_stat.uart_rx : 0.0);
+	printf("iss_cyc_mean         %.2f\n", v->count ? (double)v->cyc_sum / v->count : 0.0);
+	printf("iss_cyc_max          %u\n", v->cyc_max);
+	printf("iss_lat_max          %u\n", v->lat_max);
+	printf("iss_uart_load_pct    %.3f\n", 100.0 * (double)v->cyc_sum / (double)cip51_stat.cycles);
+	if(isr_max && (v->cyc_max > isr_max)){
+		printf("FAIL: iss_cyc_max %u over isr_max %u\n", v->cyc_max, isr_max);
+		return 3;
+	}
+	return 0;
+}
+
+static void usage(FILE* fp){
+
+	fprintf(fp, "usage: gpsdo_rxbench [key=value ...] file\n"
+		"  poll=s           getm() interval, s (0 = after every byte)\n"
+		"  hex=file         also measure the UART ISR of this image on the ISS\n"
+		"  isr_max=cycles   fail (exit 3) if that ISR runs longer than this\n");
+}
+
+//-----------------------------------------------------------------------------
+// main()
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv){
+	const char*	path = 0;
+	uint32_t	fate[NUM_FATE];
+	uint32_t	rtrn[8];
+	char*		end;
+	uint32_t	i;
+	int			a;
+
+	config_defaults();
+	for(a=1; a<argc; a++){
+		if(!strcmp(argv[a], "help")){
+			usage(stdout);
+			return 0;
+		}
+		if(!strncmp(argv[a], "poll=", 5)){
+			poll = strtod(argv[a] + 5, &end);
+			if((end == argv[a] + 5) || *end || (poll < 0.0)){
+				fprintf(stderr, "gpsdo_rxbench: bad parameter \"%s\"\n", argv[a]);
+				return 1;
+			}
+		}else if(!strncmp(argv[a], "hex=", 4)){
+			hex = argv[a] + 4;
+		}else if(!strncmp(argv[a], "isr_max=", 8)){
+			isr_max = (uint32_t)strtoul(argv[a] + 8, &end, 0);
+			if((end == argv[a] + 8) || *end){
+				fprintf(stderr, "gpsdo_rxbench: bad parameter \"%s\"\n", argv[a]);
+				return 1;
+			}
+		}else if(strchr(argv[a], '=')){
+			fprintf(stderr, "gpsdo_rxbench: bad parameter \"%s\"\n", argv[a]);
+			usage(stderr);
+			return 1;
+		}else{
+			path = argv[a];
+		}
+	}
+	if(!path){
+		usage(stderr);
+		return 1;
+	}
+	if(load(path)){
+		fprintf(stderr, "gpsdo_rxbench: can't read %s\n", path);
+		return 1;
+	}
+	scan_capture();
+	memset(rtrn, 0, sizeof(rtrn));
+	replay(rtrn);
+	memset(fate, 0, sizeof(fate));
+	for(i=0; i<nframes; i++) fate[frames[i].fate]++;
+	printf("capture_bytes        %u\n", cap_len);
+	printf("capture_s            %.3f\n", cap_len * 10.0 / BAUD);
+	printf("ubx_frames           %u\n", scan.ubx);
+	printf("ubx_bad              %u\n", scan.ubx_bad);
+	printf("nmea_sentences       %u\n", scan.nmea);
+	printf("burst_max_bytes      %u\n", scan.burst_max);
+	printf("poll_s               %g\n", poll);
+	printf("tm2_frames           %u\n", nframes);
+	for(a=FATE_ACCEPTED; a<NUM_FATE; a++){
+		printf("tm2_%-16s %u\n", fate_name[a], fate[a]);
+	}
+	if(fate[FATE_NONE]) printf("tm2_%-16s %u\n", fate_name[FATE_NONE], fate[FATE_NONE]);
+	printf("fw_rxd_novr          %u\n", rxd_novr);
+	printf("fw_rxd_novf          %u\n", rxd_novf);
+	printf("fw_rxd_nck           %u\n", rxd_nck);
+	printf("getm_0_mark          %u\n", rtrn[0]);
+	printf("getm_3_no_time       %u\n", rtrn[3]);
+	printf("getm_4_not_used      %u\n", rtrn[4]);
+	printf("host_ns_per_byte     %.1f\n", host_cost());
+	if(hex){
+		a = iss_cost(path);
+		if(a) return (a == 3) ? 3 : 1;
+	}
+	return 0;
+}
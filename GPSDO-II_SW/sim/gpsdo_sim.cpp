@@ -0,0 +1,62 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: gpsdo_sim.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   gpsdo_sim: runs the unmodified GPSDO-II firmware (main.c,
+ *             serial.c, flash.c, nvmem.c, f300_init.c) on the host against
+ *             models of the F520, the board, the OCXO and the GPS receiver,
+ *             in virtual time.  Prints a key/value summary of the run on
+ *             stdout.
+ *
+ *             gpsdo_sim [key=value ...]     ("gpsdo_sim help" lists keys)
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "config.h"
+#include "metrics.h"
+#include "instance.h"
+
+//-----------------------------------------------------------------------------
+// main()
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv){
+	clock_t	wall;
+
+	config_defaults();
+	if((argc > 1) && !strcmp(argv[1], "help")){
+		config_usage(stdout);
+		return 0;
+	}
+	if(config_parse(argc, argv)){
+		config_usage(stderr);
+		return 1;
+	}
+	wall = clock();
+	switch(sim_instance()){
+	case INST_TRACE:
+		fprintf(stderr, "gpsdo_sim: can't open %s\n", sim_cfg.trace);
+		return 1;
+	case INST_GPS:
+		fprintf(stderr, "gpsdo_sim: can't open %s\n", sim_cfg.gps_replay[0] ? sim_cfg.gps_replay : sim_cfg.gps_capture);
+		return 1;
+	case INST_RETURN:
+		fprintf(stderr, "gpsdo_sim: firmware returned from main()\n");
+		return 2;
+	}
+	metrics_report(stdout);
+	printf("wall_s            %.2f\n", (double)(clock() - wall) / CLOCKS_PER_SEC);
+	return 0;
+}
@@ -0,0 +1,541 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: gpsdo_tune.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   gpsdo_tune: searches the init.h loop parameters (KP, AVE_COUNT,
+ *             PI_TAU0, PI_TAU1, GPS_TIMEOUT; KPD is held at tune.kpd since
+ *             only KP/KPD matters) for the oscillator and receiver given by
+ *             the gpsdo_sim keys, and prints the best set as an init.h
+ *             parameter block.
+ *
+ *             The search is a pattern search from the fw.* values: each
+ *             round runs the current point and its neighbours along every
+ *             axis, tune.jobs instances at a time, moves to the best one and
+ *             halves the steps when nothing beats the current point.  Every
+ *             candidate runs the same tune.seeds seeds so that they see the
+ *             same noise, and the objective is the mean over the seeds:
+ *
+ *               adev       overlapping ADEV of the 1PPS at tune.tau
+ *               mdev       modified ADEV at tune.tau
+ *               settle     time until |y| stays within settle.y
+ *               track      time to VCO_TRACK
+ *               phase_rms  steady-state phase RMS
+ *               holdover   |phase change| over the gps.loss_at outage
+ *
+ *             The (A/M)DEV and phase figures cover the steady-state window
+ *             (last quarter of the run).  A run that fails or never gets
+ *             there scores infinity.
+ *
+ *             gpsdo_tune [tune.key=value ...] [gpsdo_sim key=value ...]
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  KP is the TRACK damping (PI loop)
+ *    10-17-26 jmh:  PI_TAU0 and PI_TAU1 are searched too
+ *
+ *******************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <vector>
+#include "config.h"
+#include "metrics.h"
+#include "instance.h"
+#include "adev.h"
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+#define	TUNE_NAME_LEN	16
+
+struct tune_config {
+	char		obj[TUNE_NAME_LEN];			// objective
+	double		tau;						// (M)ADEV tau, s
+	uint32_t	seeds;						// instances per candidate
+	uint32_t	jobs;						// concurrent instances (0 = one per core)
+	uint32_t	rounds;						// search rounds, max
+	uint32_t	kpd;						// KPD of the result
+	double		gain_min;					// KP/KPD search range
+	double		gain_max;
+	uint32_t	ave_max;					// AVE_COUNT search range 1 .. ave_max
+	uint32_t	tau0_min;					// PI_TAU0 search range, s
+	uint32_t	tau0_max;
+	uint32_t	tau1_max;					// PI_TAU1 search range PI_TAU0 .. tau1_max, s
+	double		to_min;						// GPS_TIMEOUT search range, s
+	double		to_max;
+	char		out[CFG_PATH_LEN];			// init.h block file ("" = stdout only)
+};
+
+static	tune_config	tune;
+
+enum tune_type { TUNE_DBL, TUNE_U32, TUNE_STR };
+
+struct tune_key {
+	const char*	name;
+	tune_type	type;
+	void*		p;
+	size_t		len;
+	const char*	help;
+};
+
+static const tune_key tune_keys[] = {
+	{ "tune.obj",		TUNE_STR, tune.obj,			TUNE_NAME_LEN,	"adev, mdev, settle, track, phase_rms or holdover" },
+	{ "tune.tau",		TUNE_DBL, &tune.tau,		0,	"(M)ADEV tau, s" },
+	{ "tune.seeds",		TUNE_U32, &tune.seeds,		0,	"instances per candidate" },
+	{ "tune.jobs",		TUNE_U32, &tune.jobs,		0,	"concurrent instances (0 = one per core)" },
+	{ "tune.rounds",	TUNE_U32, &tune.rounds,		0,	"search rounds, max" },
+	{ "tune.kpd",		TUNE_U32, &tune.kpd,		0,	"KPD of the result" },
+	{ "tune.gain_min",	TUNE_DBL, &tune.gain_min,	0,	"KP/KPD lower limit" },
+	{ "tune.gain_max",	TUNE_DBL, &tune.gain_max,	0,	"KP/KPD upper limit" },
+	{ "tune.ave_max",	TUNE_U32, &tune.ave_max,	0,	"AVE_COUNT upper limit" },
+	{ "tune.tau0_min",	TUNE_U32, &tune.tau0_min,	0,	"PI_TAU0 lower limit, s" },
+	{ "tune.tau0_max",	TUNE_U32, &tune.tau0_max,	0,	"PI_TAU0 upper limit, s" },
+	{ "tune.tau1_max",	TUNE_U32, &tune.tau1_max,	0,	"PI_TAU1 upper limit, s" },
+	{ "tune.to_min",	TUNE_DBL, &tune.to_min,		0,	"GPS_TIMEOUT lower limit, s" },
+	{ "tune.to_max",	TUNE_DBL, &tune.to_max,		0,	"GPS_TIMEOUT upper limit, s" },
+	{ "tune.out",		TUNE_STR, tune.out,			CFG_PATH_LEN,	"write the init.h block here too" },
+};
+
+#define	NUM_TUNE_KEYS	(sizeof(tune_keys) / sizeof(tune_keys[0]))
+
+enum tune_obj { OBJ_ADEV, OBJ_MDEV, OBJ_SETTLE, OBJ_TRACK, OBJ_PHASE, OBJ_HOLDOVER, NUM_OBJ };
+
+static const char* const obj_name[NUM_OBJ] = { "adev", "mdev", "settle", "track", "phase_rms", "holdover" };
+static const char* const obj_unit[NUM_OBJ] = { "", "", "s", "s", "ns", "ns" };
+
+static	int			obj;					// tune_obj
+static	uint32_t	adev_m;					// tune.tau / div.period
+
+// one point in the search space
+struct tune_point {
+	uint32_t	kp;
+	uint32_t	ave;
+	uint32_t	tau0;						// PI_TAU0, s
+	uint32_t	tau1;						// PI_TAU1, s
+	uint32_t	to;							// GPS_TIMEOUT, timer ticks (10 ms)
+};
+
+// what a child sends back
+struct tune_result {
+	int			status;						// INST_x, -1 = child died
+	double		score;						// objective, this seed
+	double		t_track;
+	double		t_settle;
+	double		phase_rms;
+	double		dev;						// (M)ADEV at tune.tau
+};
+
+// one candidate: a point and its seeds
+struct tune_cand {
+	tune_point	pt;
+	uint32_t	done;						// seeds back
+	double		sum;
+	double		score;						// mean over the seeds
+};
+
+// a running child
+struct tune_child {
+	pid_t		pid;
+	int			fd;
+	size_t		cand;
+	uint32_t	seed;
+};
+
+#define	TICK_S		0.01					// init.h MS_PER_TIC
+
+//-----------------------------------------------------------------------------
+// tune_set() parses one tune.key=value, returns 0 if OK
+//-----------------------------------------------------------------------------
+static int tune_set(const char* arg){
+	const char*	eq = strchr(arg, '=');
+	char*		end;
+	size_t		i;
+
+	if(!eq) return -1;
+	for(i=0; i<NUM_TUNE_KEYS; i++){
+		if((strlen(tune_keys[i].name) == (size_t)(eq - arg)) && !strncmp(tune_keys[i].name, arg, eq - arg)) break;
+	}
+	if(i == NUM_TUNE_KEYS) return -1;
+	switch(tune_keys[i].type){
+	case TUNE_DBL:
+		*(double*)tune_keys[i].p = strtod(eq + 1, &end);
+		break;
+	case TUNE_U32:
+		*(uint32_t*)tune_keys[i].p = (uint32_t)strtoul(eq + 1, &end, 0);
+		break;
+	default:
+		if(strlen(eq + 1) >= tune_keys[i].len) return -1;
+		strcpy((char*)tune_keys[i].p, eq + 1);
+		return 0;
+	}
+	return ((end == eq + 1) || *end) ? -1 : 0;
+}
+
+static void tune_usage(FILE* fp){
+	size_t	i;
+
+	fprintf(fp, "usage: gpsdo_tune [tune.key=value ...] [gpsdo_sim key=value ...]\n");
+	for(i=0; i<NUM_TUNE_KEYS; i++){
+		fprintf(fp, "  %-16s %s\n", tune_keys[i].name, tune_keys[i].help);
+	}
+	config_usage(fp);
+}
+
+//-----------------------------------------------------------------------------
+// tune_run() is the child side: one seed of one candidate
+//-----------------------------------------------------------------------------
+static void tune_run(const sim_config* base, const tune_point* pt, uint32_t seed, tune_result* r){
+	adev_state	a;
+	adev_point	dev[ADEV_MAX_TAUS];
+	int			n;
+	int			i;
+
+	sim_cfg = *base;
+	sim_cfg.seed = base->seed + seed;
+	sim_cfg.trace[0] = '\0';
+	sim_cfg.fw_kp = pt->kp;
+	sim_cfg.fw_kpd = tune.kpd;
+	sim_cfg.fw_ave_count = pt->ave;
+	sim_cfg.fw_tau0 = pt->tau0;
+	sim_cfg.fw_tau1 = pt->tau1;
+	sim_cfg.fw_gps_timeout = pt->to * TICK_S;
+	sim_adev = 0;
+	if((obj == OBJ_ADEV) || (obj == OBJ_MDEV)){
+		if(adev_init(&a, sim_cfg.div_period, adev_m) || adev_add_m(&a, adev_m)){
+			r->status = -1;
+			r->score = HUGE_VAL;
+			return;
+		}
+		sim_adev = &a;
+	}
+	r->status = sim_instance();
+	r->t_track = sim_metric.t_track;
+	r->t_settle = sim_metric.t_settle;
+	r->phase_rms = sim_metric.phase_rms;
+	r->dev = NAN;
+	if(sim_adev){
+		n = adev_result(&a, dev);
+		for(i=0; (i < n) && (dev[i].tau != adev_m * sim_cfg.div_period); i++);
+		if(i < n) r->dev = (obj == OBJ_ADEV) ? dev[i].adev : dev[i].mdev;
+		adev_free(&a);
+	}
+	switch(obj){
+	case OBJ_ADEV:
+	case OBJ_MDEV:
+		r->score = r->dev;
+		break;
+	case OBJ_SETTLE:
+		r->score = r->t_settle;
+		break;
+	case OBJ_TRACK:
+		r->score = r->t_track;
+		break;
+	case OBJ_PHASE:
+		r->score = sim_metric.ss_n ? r->phase_rms : -1.0;
+		break;
+	default:
+		r->score = fabs(sim_metric.holdover_err);
+		break;
+	}
+	if(r->status || std::isnan(r->score) || (r->score < 0.0)) r->score = HUGE_VAL;
+}
+
+//-----------------------------------------------------------------------------
+// tune_spawn() starts one seed of candidate "cand" in a child, returns 0 if OK
+//-----------------------------------------------------------------------------
+static int tune_spawn(const sim_config* base, const tune_cand* cand, size_t ci, uint32_t seed, tune_child* c){
+	int			fd[2];
+	tune_result	r;
+
+	if(pipe(fd)) return -1;
+	fflush(stdout);
+	fflush(stderr);
+	c->pid = fork();
+	if(c->pid < 0){
+		close(fd[0]);
+		close(fd[1]);
+		return -1;
+	}
+	if(c->pid == 0){
+		close(fd[0]);
+		memset(&r, 0, sizeof(r));
+		tune_run(base, &cand->pt, seed, &r);
+		_exit((write(fd[1], &r, sizeof(r)) == (ssize_t)sizeof(r)) ? 0 : 1);
+	}
+	close(fd[1]);
+	c->fd = fd[0];
+	c->cand = ci;
+	c->seed = seed;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// tune_eval() runs every seed of cands[first..] in parallel and fills in their
+//	scores, returns 0 if OK
+//-----------------------------------------------------------------------------
+static int tune_eval(const sim_config* base, std::vector<tune_cand>& cands, size_t first){
+	std::vector<tune_child>	kids;
+	tune_child				c;
+	tune_result				r;
+	size_t					next = first;
+	uint32_t				seed = 0;
+	pid_t					pid;
+	int						st;
+	size_t					i;
+
+	while((next < cands.size()) || !kids.empty()){
+		while((next < cands.size()) && (kids.size() < tune.jobs)){
+			if(tune_spawn(base, &cands[next], next, seed, &c)){
+				perror("gpsdo_tune");
+				if(kids.empty()) return -1;
+				break;
+			}
+			kids.push_back(c);
+			if(++seed == tune.seeds){
+				seed = 0;
+				next++;
+			}
+		}
+		pid = waitpid(-1, &st, 0);
+		if(pid < 0){
+			perror("gpsdo_tune");
+			return -1;
+		}
+		for(i=0; (i < kids.size()) && (kids[i].pid != pid); i++);
+		if(i == kids.size()) continue;
+		if(!WIFEXITED(st) || WEXITSTATUS(st) || (read(kids[i].fd, &r, sizeof(r)) != (ssize_t)sizeof(r))){
+			r.score = HUGE_VAL;
+		}
+		close(kids[i].fd);
+		cands[kids[i].cand].sum += r.score;
+		if(++cands[kids[i].cand].done == tune.seeds){
+			cands[kids[i].cand].score = cands[kids[i].cand].sum / tune.seeds;
+		}
+		kids.erase(kids.begin() + i);
+	}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// find() returns the index of pt in cands, or cands.size()
+//-----------------------------------------------------------------------------
+static size_t find(const std::vector<tune_cand>& cands, const tune_point& pt){
+	size_t	i;
+
+	for(i=0; i<cands.size(); i++){
+		if(!memcmp(&cands[i].pt, &pt, sizeof(pt))) break;
+	}
+	return i;
+}
+
+static void add(std::vector<tune_cand>& cands, const tune_point& pt){
+	tune_cand	c;
+
+	if(find(cands, pt) < cands.size()) return;
+	memset(&c, 0, sizeof(c));
+	c.pt = pt;
+	cands.push_back(c);
+}
+
+static void print_point(const tune_point* pt, double score){
+
+	printf("  KP %5u  AVE_COUNT %3u  PI_TAU0 %4u s  PI_TAU1 %5u s  GPS_TIMEOUT %6.2f s  %s %.4g%s%s\n", pt->kp,
+		pt->ave, pt->tau0, pt->tau1, pt->to * TICK_S, obj_name[obj], score, obj_unit[obj][0] ? " " : "", obj_unit[obj]);
+}
+
+//-----------------------------------------------------------------------------
+// emit() writes the init.h block for the result
+//-----------------------------------------------------------------------------
+static void emit(FILE* fp, const sim_config* base, const tune_point* pt, double score, double start){
+
+	fprintf(fp, "// VCO loop parameters (gpsdo_tune tune.obj=%s", obj_name[obj]);
+	if((obj == OBJ_ADEV) || (obj == OBJ_MDEV)) fprintf(fp, " tune.tau=%g", adev_m * base->div_period);
+	fprintf(fp, ": %.4g%s%s, was %.4g; %u seeds x %g h)\n", score, obj_unit[obj][0] ? " " : "", obj_unit[obj],
+		start, tune.seeds, base->hours);
+	fprintf(fp, "//\tosc.null_dac=%g osc.slope=%g osc.age1=%g osc.tempco=%g\n", base->osc_null_dac, base->osc_slope,
+		base->osc_age1, base->osc_tempco);
+	fprintf(fp, "//\tosc.wpm=%g osc.wfm=%g osc.ffm=%g osc.rwfm=%g div.period=%g\n", base->osc_wpm, base->osc_wfm,
+		base->osc_ffm, base->osc_rwfm, base->div_period);
+	fprintf(fp, "#ifndef\tKP\n");
+	fprintf(fp, "#define\tKP\t\t\t%uL\t\t\t// TRACK damping, KP/KPD x the critically damped P gain (2 G / tau)\n", pt->kp);
+	fprintf(fp, "#define\tKPD\t\t\t%uL\n", tune.kpd);
+	fprintf(fp, "#endif\n");
+	fprintf(fp, "#ifndef\tAVE_COUNT\n");
+	fprintf(fp, "#define\tAVE_COUNT\t%u\t\t\t\t// longest TRACK window (DAC update), in DIV_MS periods\n", pt->ave);
+	fprintf(fp, "#endif\n");
+	fprintf(fp, "#ifndef\tPI_TAU0\n");
+	fprintf(fp, "#define\tPI_TAU0\t\t%uL\t\t\t\t// TRACK loop time constant out of AQS, s..\n", pt->tau0);
+	fprintf(fp, "#define\tPI_TAU1\t\t%uL\t\t\t// ..doubled up to this while the phase holds\n", pt->tau1);
+	fprintf(fp, "#endif\n");
+	fprintf(fp, "#ifndef\tGPS_TIMEOUT\n");
+	fprintf(fp, "#define\tGPS_TIMEOUT\t\t(%u/MS_PER_TIC)\t// no valid time-mark for this long: DR mode\n",
+		(unsigned)(pt->to * TICK_S * 1000.0 + 0.5));
+	fprintf(fp, "#endif\n");
+}
+
+//-----------------------------------------------------------------------------
+// main()
+//-----------------------------------------------------------------------------
+int main(int argc, char** argv){
+	std::vector<tune_cand>	cands;
+	sim_config				base;
+	tune_point				cur;
+	tune_point				p;
+	double					kstep = 2.0;		// KP step, factor
+	uint32_t				astep = 2;			// AVE_COUNT step
+	double					wstep = 2.0;		// PI_TAU0, PI_TAU1 step, factor
+	uint32_t				tstep;				// GPS_TIMEOUT step, ticks
+	uint32_t				kp_min, kp_max;
+	uint32_t				to_min, to_max;
+	uint32_t				round;
+	size_t					first;
+	size_t					best;
+	size_t					ci;
+	size_t					i;
+	int						moved;
+	FILE*					fp;
+
+	config_defaults();
+	sim_cfg.hours = 6.0;
+	memset(&tune, 0, sizeof(tune));
+	strcpy(tune.obj, "adev");
+	tune.tau = 100.0;
+	tune.seeds = 4;
+	tune.rounds = 20;
+	tune.kpd = 1000;
+	tune.gain_min = 0.01;
+	tune.gain_max = 10.0;
+	tune.ave_max = 30;
+	tune.tau0_min = 10;
+	tune.tau0_max = 320;
+	tune.tau1_max = 5120;
+	tune.to_min = 0.0;							// one divider period + 1 s
+	tune.to_max = 60.0;
+	if((argc > 1) && !strcmp(argv[1], "help")){
+		tune_usage(stdout);
+		return 0;
+	}
+	for(i=1; i<(size_t)argc; i++){
+		if(strncmp(argv[i], "tune.", 5) ? config_set(argv[i]) : tune_set(argv[i])){
+			fprintf(stderr, "gpsdo_tune: bad parameter \"%s\"\n", argv[i]);
+			tune_usage(stderr);
+			return 1;
+		}
+	}
+	for(obj=0; (obj < NUM_OBJ) && strcmp(tune.obj, obj_name[obj]); obj++);
+	if(obj == NUM_OBJ){
+		fprintf(stderr, "gpsdo_tune: unknown objective \"%s\"\n", tune.obj);
+		return 1;
+	}
+	if((obj == OBJ_HOLDOVER) && (sim_cfg.gps_loss_at < 0.0)){
+		fprintf(stderr, "gpsdo_tune: tune.obj=holdover needs gps.loss_at\n");
+		return 1;
+	}
+	adev_m = (uint32_t)(tune.tau / sim_cfg.div_period + 0.5);
+	if(adev_m < 1) adev_m = 1;
+	if(!tune.seeds || !tune.kpd || !tune.ave_max || !tune.tau0_min || !sim_cfg.fw_kpd){
+		fprintf(stderr, "gpsdo_tune: tune.seeds, tune.kpd, tune.ave_max, tune.tau0_min and fw.kpd must be > 0\n");
+		return 1;
+	}
+	if(tune.tau0_max < tune.tau0_min) tune.tau0_max = tune.tau0_min;
+	if(tune.tau1_max < tune.tau0_max) tune.tau1_max = tune.tau0_max;
+	if(tune.jobs == 0) tune.jobs = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+	if(tune.jobs == 0) tune.jobs = 1;
+	if(tune.to_min <= 0.0) tune.to_min = sim_cfg.div_period + 1.0;
+	kp_min = (uint32_t)fmax(1.0, ceil(tune.gain_min * tune.kpd));
+	kp_max = (uint32_t)fmax(kp_min, floor(tune.gain_max * tune.kpd));
+	to_min = (uint32_t)ceil(tune.to_min / TICK_S);
+	to_max = (uint32_t)fmax(to_min, fmin(floor(tune.to_max / TICK_S), 65535.0));
+	// start from the fw.* values (init.h by default)
+	cur.kp = (uint32_t)((double)sim_cfg.fw_kp * tune.kpd / sim_cfg.fw_kpd + 0.5);
+	cur.kp = (cur.kp < kp_min) ? kp_min : (cur.kp > kp_max) ? kp_max : cur.kp;
+	cur.ave = (sim_cfg.fw_ave_count < 1) ? 1 : (sim_cfg.fw_ave_count > tune.ave_max) ? tune.ave_max : sim_cfg.fw_ave_count;
+	cur.tau0 = (sim_cfg.fw_tau0 < tune.tau0_min) ? tune.tau0_min : (sim_cfg.fw_tau0 > tune.tau0_max) ? tune.tau0_max : sim_cfg.fw_tau0;
+	cur.tau1 = (sim_cfg.fw_tau1 < cur.tau0) ? cur.tau0 : (sim_cfg.fw_tau1 > tune.tau1_max) ? tune.tau1_max : sim_cfg.fw_tau1;
+	cur.to = (uint32_t)(sim_cfg.fw_gps_timeout / TICK_S + 0.5);
+	cur.to = (cur.to < to_min) ? to_min : (cur.to > to_max) ? to_max : cur.to;
+	tstep = (uint32_t)(5.0 / TICK_S);
+	base = sim_cfg;
+	printf("tune.obj %s, %u seeds x %g h, %u jobs\n", obj_name[obj], tune.seeds, base.hours, tune.jobs);
+	add(cands, cur);
+	for(round=1; round<=tune.rounds; round++){
+		// the current point and its neighbours on each axis
+		first = cands.size();
+		p = cur;
+		p.kp = (uint32_t)fmin(kp_max, fmax(kp_min, floor(cur.kp * kstep + 0.5)));
+		add(cands, p);
+		p.kp = (uint32_t)fmin(kp_max, fmax(kp_min, floor(cur.kp / kstep + 0.5)));
+		add(cands, p);
+		p = cur;
+		p.ave = (cur.ave + astep > tune.ave_max) ? tune.ave_max : cur.ave + astep;
+		add(cands, p);
+		p.ave = (cur.ave > astep) ? cur.ave - astep : 1;
+		add(cands, p);
+		p = cur;
+		p.tau0 = (uint32_t)fmin(tune.tau0_max, fmax(tune.tau0_min, floor(cur.tau0 * wstep + 0.5)));
+		if(p.tau1 < p.tau0) p.tau1 = p.tau0;			// PI_TAU1 >= PI_TAU0
+		add(cands, p);
+		p = cur;
+		p.tau0 = (uint32_t)fmin(tune.tau0_max, fmax(tune.tau0_min, floor(cur.tau0 / wstep + 0.5)));
+		add(cands, p);
+		p = cur;
+		p.tau1 = (uint32_t)fmin(tune.tau1_max, fmax(cur.tau0, floor(cur.tau1 * wstep + 0.5)));
+		add(cands, p);
+		p.tau1 = (uint32_t)fmin(tune.tau1_max, fmax(cur.tau0, floor(cur.tau1 / wstep + 0.5)));
+		add(cands, p);
+		p = cur;
+		p.to = (cur.to + tstep > to_max) ? to_max : cur.to + tstep;
+		add(cands, p);
+		p.to = (cur.to > to_min + tstep) ? cur.to - tstep : to_min;
+		add(cands, p);
+		if(round == 1) first = 0;
+		if(tune_eval(&base, cands, first)) return 1;
+		ci = find(cands, cur);
+		best = ci;
+		for(i=0; i<cands.size(); i++){
+			if(cands[i].score < cands[best].score) best = i;
+		}
+		moved = (best != ci) && (cands[best].score < cands[ci].score);
+		printf("round %2u: %zu candidates run, steps x%.3f/%u/x%.3f/%.2f s\n", round, cands.size(), kstep, astep, wstep,
+			tstep * TICK_S);
+		print_point(&cands[best].pt, cands[best].score);
+		if(moved){
+			cur = cands[best].pt;
+			continue;
+		}
+		if((kstep < 1.03) && (astep == 1) && (wstep < 1.03) && (tstep <= (uint32_t)(0.5 / TICK_S))) break;
+		kstep = sqrt(kstep);
+		wstep = sqrt(wstep);
+		astep = (astep > 1) ? astep / 2 : 1;
+		tstep = (tstep > (uint32_t)(1.0 / TICK_S)) ? tstep / 2 : (uint32_t)(0.5 / TICK_S);
+	}
+	ci = find(cands, cur);
+	if(isinf(cands[ci].score)){
+		fprintf(stderr, "gpsdo_tune: no candidate met the objective (all runs failed or never got there)\n");
+		return 2;
+	}
+	printf("\n");
+	emit(stdout, &base, &cur, cands[ci].score, cands[0].score);
+	if(tune.out[0]){
+		fp = fopen(tune.out, "w");
+		if(!fp){
+			fprintf(stderr, "gpsdo_tune: can't open %s\n", tune.out);
+			return 1;
+		}
+		emit(fp, &base, &cur, cands[ci].score, cands[0].score);
+		fclose(fp);
+	}
+	return 0;
+}
@@ -0,0 +1,242 @@
+//-----------------------------------------------------------------------------
+// C8051F520.h  (host simulation mock)
+//-----------------------------------------------------------------------------
+//
+// Program Description:
+//
+// Register/bit definitions for the C8051F52x/'F53x family, host build.
+//
+// This file shadows ../c8051F520.h when the firmware is compiled by the
+// gpsdo_sim Makefile.  The register names, addresses and bit positions are
+// copied one-for-one from the SiLabs header; each "sfr" becomes a sim_sfr
+// and each "sbit" a sim_sbit so that accesses go through the simulated
+// register file (sfr.cpp) instead of hardware.
+//
+// Target:         gpsdo_sim (host)
+// Tool chain:     g++
+//
+
+//-----------------------------------------------------------------------------
+// Header File Preprocessor Directive
+//-----------------------------------------------------------------------------
+
+#ifndef C8051F520_H
+#define C8051F520_H
+
+#include "sfr.h"
+
+#define SIM_SFR(name, addr)			inline constexpr sim_sfr name { addr }
+#define SIM_SBIT(name, reg, bitn)	inline constexpr sim_sbit name = reg^bitn
+
+//-----------------------------------------------------------------------------
+// Byte Registers
+//-----------------------------------------------------------------------------
+
+SIM_SFR(P0,         0x80);                 // Port 0 Latch
+SIM_SFR(SP,         0x81);                 // Stack Pointer
+SIM_SFR(DPL,        0x82);                 // Data Pointer - Low byte
+SIM_SFR(DPH,        0x83);                 // Data Pointer - High byte
+SIM_SFR(PCON,       0x87);                 // Power Control
+SIM_SFR(TCON,       0x88);                 // Timer Control
+SIM_SFR(TMOD,       0x89);                 // Timer Mode
+SIM_SFR(TL0,        0x8A);                 // Timer 0 - Low byte
+SIM_SFR(TL1,        0x8B);                 // Timer 1 - Low byte
+SIM_SFR(TH0,        0x8C);                 // Timer 0 - High byte
+SIM_SFR(TH1,        0x8D);                 // Timer 1 - High byte
+SIM_SFR(CKCON,      0x8E);                 // Clock Control
+SIM_SFR(PSCTL,      0x8F);                 // Program Store R/W Control
+SIM_SFR(P1,         0x90);                 // Port 1 Latch
+SIM_SFR(LINADDR,    0x92);                 // LIN Indirect Access Address
+SIM_SFR(LINDATA,    0x93);                 // LIN Indirect Access Data
+SIM_SFR(LINCF,      0x95);                 // LIN Configuration
+SIM_SFR(SCON0,      0x98);                 // UART0 Control
+SIM_SFR(SBUF0,      0x99);                 // UART0 Buffer
+SIM_SFR(CPT0CN,     0x9B);                 // Comparator 0 Control
+SIM_SFR(CPT0MD,     0x9D);                 // Comparator 0 Mode
+SIM_SFR(CPT0MX,     0x9F);                 // Comparator 0 Mux
+SIM_SFR(SPI0CFG,    0xA1);                 // SPI0 Configuration
+SIM_SFR(SPI0CKR,    0xA2);                 // SPI0 Clock Rate
+SIM_SFR(SPI0DAT,    0xA3);                 // SPI0 Data
+SIM_SFR(P0MDOUT,    0xA4);                 // Port 0 Output Mode Configuration
+SIM_SFR(P1MDOUT,    0xA5);                 // Port 1 Output Mode Configuration
+SIM_SFR(IE,         0xA8);                 // Interrupt Enable
+SIM_SFR(CLKSEL,     0xA9);                 // Clock Select
+SIM_SFR(OSCIFIN,    0xB0);                 // Internal Fine Oscillator Calibration
+SIM_SFR(OSCXCN,     0xB1);                 // External Oscillator Control
+SIM_SFR(OSCICN,     0xB2);                 // Internal Oscillator Control
+SIM_SFR(OSCICL,     0xB3);                 // Internal Oscillator Calibration
+SIM_SFR(FLKEY,      0xB7);                 // Flash Lock & Key
+SIM_SFR(IP,         0xB8);                 // Interrupt Priority
+SIM_SFR(ADC0TK,     0xBA);                 // ADC0 Tracking
+SIM_SFR(ADC0MX,     0xBB);                 // ADC0 Mux Channel Selection
+SIM_SFR(ADC0CF,     0xBC);                 // ADC0 CONFIGURATION
+SIM_SFR(ADC0L,      0xBD);                 // ADC0 LSB Result
+SIM_SFR(ADC0H,      0xBE);                 // ADC0 Data
+SIM_SFR(P1MASK,     0xBF);                 // Port 1 Mask
+SIM_SFR(ADC0GTL,    0xC3);                 // ADC0 Greater-Than Compare Low
+SIM_SFR(ADC0GTH,    0xC4);                 // ADC0 Greater-Than Compare High
+SIM_SFR(ADC0LTL,    0xC5);                 // ADC0 Less-Than Compare Word Low
+SIM_SFR(ADC0LTH,    0xC6);                 // ADC0 Less-Than Compare Word High
+SIM_SFR(P0MASK,     0xC7);                 // Port 1 Mask
+SIM_SFR(TMR2CN,     0xC8);                 // Timer 2 Control
+SIM_SFR(REG0CN,     0xC9);                 // Regulator Control
+SIM_SFR(TMR2RLL,    0xCA);                 // Timer 2 Reload Low
+SIM_SFR(TMR2RLH,    0xCB);                 // Timer 2 Reload High
+SIM_SFR(TMR2L,      0xCC);                 // Timer 2 Low Byte
+SIM_SFR(TMR2H,      0xCD);                 // Timer 2 High Byte
+SIM_SFR(P1MAT,      0xCF);                 // Port1 Match
+SIM_SFR(PSW,        0xD0);                 // Program Status Word
+SIM_SFR(REF0CN,     0xD1);                 // Voltage Reference 0 Control
+SIM_SFR(P0SKIP,     0xD4);                 // Port 0 Skip
+SIM_SFR(P1SKIP,     0xD5);                 // Port 1 Skip
+SIM_SFR(P0MAT,      0xD7);                 // Port 0 Match
+SIM_SFR(PCA0CN,     0xD8);                 // PCA0 Control
+SIM_SFR(PCA0MD,     0xD9);                 // PCA0 Mode
+SIM_SFR(PCA0CPM0,   0xDA);                 // PCA0 Module 0 Mode
+SIM_SFR(PCA0CPM1,   0xDB);                 // PCA0 Module 1 Mode
+SIM_SFR(PCA0CPM2,   0xDC);                 // PCA0 Module 2 Mode
+SIM_SFR(ACC,        0xE0);                 // Accumulator
+SIM_SFR(XBR0,       0xE1);                 // Digital Crossbar Configuration 0
+SIM_SFR(XBR1,       0xE2);                 // Digital Crossbar Configuration 1
+SIM_SFR(IT01CF,     0xE4);                 // INT0/INT1 Configuration
+SIM_SFR(EIE1,       0xE6);                 // Extended Interrupt Enable 1
+SIM_SFR(ADC0CN,     0xE8);                 // ADC 0 Control
+SIM_SFR(PCA0CPL1,   0xE9);                 // PCA0 Module 1 Capture/Compare Low Byte
+SIM_SFR(PCA0CPH1,   0xEA);                 // PCA0 Module 1 Capture/Compare High Byte
+SIM_SFR(PCA0CPL2,   0xEB);                 // PCA0 Module 2 Capture/Compare Low Byte
+SIM_SFR(PCA0CPH2,   0xEC);                 // PCA0 Module 2 Capture/Compare High Byte
+SIM_SFR(RSTSRC,     0xEF);                 // Reset Source Configuration/Status
+SIM_SFR(B,          0xF0);                 // B Register
+SIM_SFR(P0MDIN,     0xF1);                 // Port 0 Input Mode
+SIM_SFR(P1MDIN,     0xF2);                 // Port 1 Input Mode
+SIM_SFR(EIP1,       0xF6);                 // Extended Interrupt Priority 1
+SIM_SFR(SPI0CN,     0xF8);                 // SPI0 Control
+SIM_SFR(PCA0L,      0xF9);                 // PCA0 Counter Low Byte
+SIM_SFR(PCA0H,      0xFA);                 // PCA0 Counter High Byte
+SIM_SFR(PCA0CPL0,   0xFB);                 // PCA Module 0 Capture/Compare Low Byte
+SIM_SFR(PCA0CPH0,   0xFC);                 // PCA Module 0 Capture/Compare High Byte
+SIM_SFR(VDDMON,     0xFF);                 // VDD Monitor
+
+//-----------------------------------------------------------------------------
+// Bit Definitions
+//-----------------------------------------------------------------------------
+
+// TCON  0x88
+SIM_SBIT(TF1,       TCON, 7);          // Timer 1 Overflow Flag
+SIM_SBIT(TR1,       TCON, 6);          // Timer 1 On/Off Control
+SIM_SBIT(TF0,       TCON, 5);          // Timer 0 Overflow Flag
+SIM_SBIT(TR0,       TCON, 4);          // Timer 0 On/Off Control
+SIM_SBIT(IE1,       TCON, 3);          // External Interrupt 1 Edge Flag
+SIM_SBIT(IT1,       TCON, 2);          // External Interrupt 1 Type
+SIM_SBIT(IE0,       TCON, 1);          // External Interrupt 0 Edge Flag
+SIM_SBIT(IT0,       TCON, 0);          // External Interrupt 0 Type
+
+// SCON0  0x98
+SIM_SBIT(S0MODE,    SCON0, 7);         // Serial Mode Control Bit 0
+                                       // Bit6 UNUSED
+SIM_SBIT(MCE0,      SCON0, 5);         // Multiprocessor Communication Enable
+SIM_SBIT(REN0,      SCON0, 4);         // Receive Enable
+SIM_SBIT(TB80,      SCON0, 3);         // Transmit Bit 8
+SIM_SBIT(RB80,      SCON0, 2);         // Receive Bit 8
+SIM_SBIT(TI0,       SCON0, 1);         // Transmit Interrupt Flag
+SIM_SBIT(RI0,       SCON0, 0);         // Receive Interrupt Flag
+
+// IE  0xA8
+SIM_SBIT(EA,        IE, 7);            // Global Interrupt Enable
+SIM_SBIT(ESPI0,     IE, 6);            // SPI0 Interrupt Enable
+SIM_SBIT(ET2,       IE, 5);            // Timer 2 Interrupt Enable
+SIM_SBIT(ES0,       IE, 4);            // UART0 Interrupt Enable
+SIM_SBIT(ET1,       IE, 3);            // Timer 1 Interrupt Enable
+SIM_SBIT(EX1,       IE, 2);            // External Interrupt 1 Enable
+SIM_SBIT(ET0,       IE, 1);            // Timer 0 Interrupt Enable
+SIM_SBIT(EX0,       IE, 0);            // External Interrupt 0 Enable
+
+// IP  0xB8
+                                       // Bit7 UNUSED
+SIM_SBIT(PSPI0,     IP, 6);            // SPI0 Interrupt Priority
+SIM_SBIT(PT2,       IP, 5);            // Timer 2 Priority
+SIM_SBIT(PS0,       IP, 4);            // UART0 Priority
+SIM_SBIT(PT1,       IP, 3);            // Timer 1 Priority
+SIM_SBIT(PX1,       IP, 2);            // External Interrupt 1 Priority
+SIM_SBIT(PT0,       IP, 1);            // Timer 0 Priority
+SIM_SBIT(PX0,       IP, 0);            // External Interrupt 0 Priority
+
+// TMR2CN 0xC8
+SIM_SBIT(TF2H,      TMR2CN, 7);        // Timer 2 High-Byte Overflow Flag
+SIM_SBIT(TF2L,      TMR2CN, 6);        // Timer 2 Low-Byte  Overflow Flag
+SIM_SBIT(TF2LEN,    TMR2CN, 5);        // Timer 2 Low-Byte Flag Enable
+SIM_SBIT(TF2CEN,    TMR2CN, 4);        // Timer 2 Capture Enable
+SIM_SBIT(T2SPLIT,   TMR2CN, 3);        // Timer 2 Split-Mode Enable
+SIM_SBIT(TR2,       TMR2CN, 2);        // Timer 2 On/Off Control
+SIM_SBIT(T2RCLK,    TMR2CN, 1);        // Timer 2 Xclk/Rclk Select
+SIM_SBIT(T2XCLK,    TMR2CN, 0);        // Timer 2 Clk/8 Clock Source
+
+// PSW 0xD0
+SIM_SBIT(CY,        PSW, 7);           // Carry Flag
+SIM_SBIT(AC,        PSW, 6);           // Auxiliary Carry Flag
+SIM_SBIT(F0,        PSW, 5);           // User Flag 0
+SIM_SBIT(RS1,       PSW, 4);           // Register Bank Select 1
+SIM_SBIT(RS0,       PSW, 3);           // Register Bank Select 0
+SIM_SBIT(OV,        PSW, 2);           // Overflow Flag
+SIM_SBIT(F1,        PSW, 1);           // User Flag 1
+SIM_SBIT(P,         PSW, 0);           // Accumulator Parity Flag
+
+// PCA0CN 0xD8
+SIM_SBIT(CF,        PCA0CN, 7);        // PCA0 Counter Overflow Flag
+SIM_SBIT(CR,        PCA0CN, 6);        // PCA0 Counter Run Control Bit
+                                       // Bit5 UNUSED
+                                       // Bit4 UNUSED
+                                       // Bit3 UNUSED
+SIM_SBIT(CCF2,      PCA0CN, 2);        // PCA0 Module 2 Interrupt Flag
+SIM_SBIT(CCF1,      PCA0CN, 1);        // PCA0 Module 1 Interrupt Flag
+SIM_SBIT(CCF0,      PCA0CN, 0);        // PCA0 Module 0 Interrupt Flag
+
+// ADC0CN 0xE8
+SIM_SBIT(AD0EN,     ADC0CN, 7);        // ADC0 Enable
+SIM_SBIT(BURSTEN,   ADC0CN, 6);        // ADC0 Burst Enable
+SIM_SBIT(AD0INT,    ADC0CN, 5);        // ADC0 Conversion Complete Interrupt Flag
+SIM_SBIT(AD0BUSY,   ADC0CN, 4);        // ADC0 Busy Flag
+SIM_SBIT(AD0WINT,   ADC0CN, 3);        // ADC0 Window Compare Interrupt Flag
+SIM_SBIT(AD0LJST,   ADC0CN, 2);        // ADC0 Left Justified
+SIM_SBIT(AD0CM1,    ADC0CN, 1);        // ADC0 Start Of Conversion Mode Bit 1
+SIM_SBIT(AD0CM0,    ADC0CN, 0);        // ADC0 Start Of Conversion Mode Bit 0
+
+// SPI0CN 0xF8
+SIM_SBIT(SPIF,      SPI0CN, 7);        // SPI0 Interrupt Flag
+SIM_SBIT(WCOL,      SPI0CN, 6);        // SPI0 Write Collision Flag
+SIM_SBIT(MODF,      SPI0CN, 5);        // SPI0 Mode Fault Flag
+SIM_SBIT(RXOVRN,    SPI0CN, 4);        // SPI0 Rx Overrun Flag
+SIM_SBIT(NSSMD1,    SPI0CN, 3);        // SPI0 NSS Mode Bit 1
+SIM_SBIT(NSSMD0,    SPI0CN, 2);        // SPI0 NSS Mode Bit 0
+SIM_SBIT(TXBMT,     SPI0CN, 1);        // SPI0 Transmit Buffer Empty Flag
+SIM_SBIT(SPIEN,     SPI0CN, 0);        // SPI0 Enable
+
+//-----------------------------------------------------------------------------
+// Interrupt Priorities
+//-----------------------------------------------------------------------------
+
+#define INTERRUPT_INT0                 0  // External Interrupt 0
+#define INTERRUPT_TIMER0               1  // Timer0 Overflow
+#define INTERRUPT_INT1                 2  // External Interrupt 1
+#define INTERRUPT_TIMER1               3  // Timer1 Overflow
+#define INTERRUPT_UART0                4  // Serial Port 0
+#define INTERRUPT_TIMER2               5  // Timer2 Overflow
+#define INTERRUPT_SPI0                 6  // Serial Peripheral Interface 0
+#define INTERRUPT_ADC0_WINDOW          7  // ADC0 Window Comparison
+#define INTERRUPT_ADC0_EOC             8  // ADC0 End Of Conversion
+#define INTERRUPT_PCA0                 9  // PCA0 Peripheral
+#define INTERRUPT_COMPARATOR_FALLING  10  // Comparator Falling edge
+#define INTERRUPT_COMPARATOR_RISING   11  // Comparator Rising edge
+#define INTERRUPT_LIN                 12  // LIN interrupt
+#define INTERRUPT_VREG                13  // Voltage Regulator Dropout
+#define INTERRUPT_PORT_MATCH          14  // Port Match
+
+//-----------------------------------------------------------------------------
+// Header File PreProcessor Directive
+//-----------------------------------------------------------------------------
+
+#endif                                 // #define C8051F520_H
+
+//-----------------------------------------------------------------------------
+// End Of File
+//-----------------------------------------------------------------------------
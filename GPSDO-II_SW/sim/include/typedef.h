@@ -0,0 +1,41 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: typedef.h  (host simulation)
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This header shadows ../typedef.h for the gpsdo_sim build.
+ *       The C51 sizes are kept (int = 16 bits, long = 32 bits) so that
+ *       wrap-around and flash layout match the target.
+ *
+ *       S8 maps to plain char (built with -funsigned-char): C51 compares
+ *       two 8-bit operands with CJNE, so the byte compares in serial.c
+ *       (sync, class/id, checksum) behave as unsigned on the target.
+ *
+ *******************************************************************/
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+
+/* data definitions */
+
+#define U8                 unsigned char
+#define S8                 char
+#define U16                unsigned short
+#define S16                signed short
+#define U32                unsigned int
+#define S32                signed int
+#define F32                float
+#define F64                double
+#define BOOL               unsigned char
+
+#define TRUE               1
+#define FALSE              0
+
+
+#define TYPEDEF_INCLUDED
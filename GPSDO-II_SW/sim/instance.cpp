@@ -0,0 +1,87 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: instance.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   One simulated GPSDO-II run with the parameters in sim_cfg.
+ *             The firmware keeps its state in file-scope globals (as the
+ *             C51 build does), so an instance can run only once per process:
+ *             gpsdo_sim runs one, gpsdo_mc forks a process for each.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  gps.capture / gps.replay files
+ *    10-17-26 jmh:  Timer0_ISR gone (SPI on SPI0)
+ *    10-17-26 jmh:  spi_intr
+ *    10-17-26 jmh:  acc_ndeg, acc_nrej to the metrics
+ *    10-17-26 jmh:  cflag (lock quality) to the metrics
+ *
+ *******************************************************************/
+
+#include "c8051F520.h"
+#include "kernel.h"
+#include "sfr.h"
+#include "mcu.h"
+#include "cseg.h"
+#include "board.h"
+#include "ad5761.h"
+#include "ds1722.h"
+#include "plant.h"
+#include "ublox.h"
+#include "config.h"
+#include "metrics.h"
+#include "instance.h"
+
+//------------------------------------------------------------------------------
+// firmware entry (main.c, renamed by keil51.h), ISRs, LED state and the
+//	time-mark reject counts
+//------------------------------------------------------------------------------
+
+void gpsdo_main(void);
+void rxd_intr(void);
+void Timer2_ISR(void);
+void spi_intr(void);
+void pca_intr(void);
+
+extern volatile unsigned char blinkpwm;
+extern volatile unsigned char cflag;
+extern unsigned short acc_ndeg;
+extern unsigned short acc_nrej;
+
+//-----------------------------------------------------------------------------
+// sim_instance() powers up the board and runs the firmware to the end of the
+//	run.  Results are left in sim_metric and the model stats.
+//-----------------------------------------------------------------------------
+int sim_instance(void){
+	double	t_end = sim_cfg.hours * 3600.0;
+
+	if(metrics_init(t_end)) return INST_TRACE;
+	// power-on reset
+	sfr_reset();
+	mcu_init();
+	mcu_set_isr(INTERRUPT_UART0, rxd_intr);
+	mcu_set_isr(INTERRUPT_TIMER2, Timer2_ISR);
+	mcu_set_isr(INTERRUPT_SPI0, spi_intr);
+	mcu_set_isr(INTERRUPT_PCA0, pca_intr);
+	sim_blinkpwm = &blinkpwm;
+	sim_cflag = &cflag;
+	sim_acc_ndeg = &acc_ndeg;
+	sim_acc_nrej = &acc_nrej;
+	cseg_init();
+	cseg_set_dac((int)sim_cfg.flash_dac);
+	board_init();
+	plant_init();
+	ad5761_init();
+	ds1722_init();
+	if(ublox_init()) return INST_GPS;
+	if(sim_run(sim_cycles(t_end), gpsdo_main)) return INST_RETURN;
+	metrics_done();
+	ublox_done();
+	return INST_OK;
+}
@@ -0,0 +1,40 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: instance.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This is the header file for one simulated GPSDO-II run from
+ *             power-on to the end of sim_cfg.hours.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  INST_GPS
+ *
+ *******************************************************************/
+
+#ifndef SIM_INSTANCE_H
+#define SIM_INSTANCE_H
+
+//------------------------------------------------------------------------------
+// extern defines
+//------------------------------------------------------------------------------
+
+// sim_instance() return codes
+#define	INST_OK		0
+#define	INST_TRACE	1						// can't open the trace file
+#define	INST_RETURN	2						// firmware returned from main()
+#define	INST_GPS	3						// can't open gps.capture or gps.replay
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+int sim_instance(void);
+
+#endif
@@ -0,0 +1,123 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: keil51.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   C51 dialect shim, force-included (-include) ahead of every
+ *             firmware source in the gpsdo_sim build.  The firmware files
+ *             are compiled as C++ so that sfr/sbit accesses can be trapped
+ *             by the simulated register file.
+ *
+ *             Memory-space qualifiers (data, idata, xdata) vanish.  "code"
+ *             places the object in the "cseg" section so that the host image
+ *             of the F520 code space (cseg.cpp) can follow dac_save[] the way
+ *             the linker lays it out at 0x1C00.
+ *
+ *             The Makefile rewrites "interrupt n [using r]" to SIM_ISR(n)
+ *             when it stages the sources; the ISRs are then plain functions
+ *             called from the vector table in mcu.cpp.
+ *
+ *             while() is wrapped so that a loop which polls an SFR bit or a
+ *             volatile variable (e.g. "while(!SPIF);", "while(waittimer);") is
+ *             recognized as waiting on an interrupt and lets virtual time
+ *             advance.  A masked flag byte ("while(job.st & SPI_BUSY);") is
+ *             an int that isn't a constant, so that is taken as a poll too.
+ *             All other loops are untouched.
+ *
+ *             The init.h loop parameters (KP, KPD, AVE_COUNT, GPS_TIMEOUT, TP_QERR,
+ *             PI_TAU0, PI_TAU1)
+ *             are taken from sim_cfg (fw.* keys) so that one binary can run
+ *             any parameter set; init.h only defines them when they are not
+ *             already defined.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  init.h loop parameters from sim_cfg
+ *    10-17-26 jmh:  "while(!bit)" is a hardware flag poll too
+ *    10-17-26 jmh:  TP_QERR
+ *    10-17-26 jmh:  PCA_FUSE
+ *    10-17-26 jmh:  PCA_FUSE removed
+ *    10-17-26 jmh:  "while(flags & MASK)" is a flag poll too
+ *
+ *******************************************************************/
+
+#ifndef KEIL51_H
+#define KEIL51_H
+
+// system headers go in before the keyword macros below
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#include "sfr.h"
+#include "kernel.h"
+#include "config.h"
+
+//-----------------------------------------------------------------------------
+// C51 keywords
+//-----------------------------------------------------------------------------
+
+#define	data
+#define	idata
+#define	pdata
+#define	xdata
+#define	bdata
+#define	code		__attribute__((section("cseg")))
+#define	bit			bool
+#define	sbit		constexpr sim_sbit
+#define	SIM_ISR(vector)
+
+#define	main		gpsdo_main				// firmware entry point, called by sim_run()
+
+//-----------------------------------------------------------------------------
+// init.h loop parameters (C51 long is 32 bits)
+//-----------------------------------------------------------------------------
+
+#define	KP			((int32_t)sim_cfg.fw_kp)
+#define	KPD			((int32_t)sim_cfg.fw_kpd)
+#define	AVE_COUNT	((uint16_t)sim_cfg.fw_ave_count)
+#define	GPS_TIMEOUT	((uint16_t)(sim_cfg.fw_gps_timeout * 1000.0 / MS_PER_TIC + 0.5))
+#define	TP_QERR		((uint8_t)sim_cfg.fw_qerr)
+#define	PI_TAU0		((int32_t)sim_cfg.fw_tau0)
+#define	PI_TAU1		((int32_t)sim_cfg.fw_tau1)
+
+//-----------------------------------------------------------------------------
+// wait-for-interrupt loop detection
+//-----------------------------------------------------------------------------
+
+template<class T> struct sim_hw_flag {
+	typedef typename std::remove_reference<T>::type	type;
+	typedef typename std::remove_cv<type>::type		base;
+	static const bool value = std::is_volatile<type>::value ||
+		std::is_same<base, sim_sbit>::value || std::is_same<base, sim_sbit_not>::value ||
+		std::is_same<base, sim_sfr>::value;
+};
+
+template<bool SPIN, class T> inline bool sim_loop_poll(const T& c, bool mask){
+
+	if(!c) return false;
+	if(SPIN || mask) sim_spin();			// only an ISR can change c, let time run
+	return true;
+}
+
+// int (the promoted "flags & MASK"), and not a constant ("while(1)")
+#define	sim_mask_poll(c)	(std::is_same<decltype((c)), int>::value && !__builtin_constant_p(c))
+
+#define	while(c)	while(sim_loop_poll<sim_hw_flag<decltype((c))>::value>((c), sim_mask_poll(c)))
+
+//-----------------------------------------------------------------------------
+// code-space address shim
+//	C51 converts an integer code address (START_ADDR) to an xdata pointer; the
+//	overload maps it onto the host image of the code space.
+//-----------------------------------------------------------------------------
+
+unsigned char erase_flash(unsigned int xaddr);
+
+#endif
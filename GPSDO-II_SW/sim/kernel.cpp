@@ -0,0 +1,277 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: kernel.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   Virtual-time kernel for gpsdo_sim.  Event sources (timers,
+ *             PCA edges, UART bytes, GPS epochs) register a fire function
+ *             and a due time; pending sources sit in a priority queue.  When
+ *             the firmware idles or spins on a flag, the kernel jumps to the
+ *             earliest event, fires it and runs the enabled ISRs in vector
+ *             order.  Idle time costs nothing.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  event queue is a heap, flag polling loops skip to the next event
+ *    10-17-26 jmh:  external CPU interface for gpsdo_iss
+ *    10-17-26 jmh:  sim_reset()
+ *
+ *******************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include "kernel.h"
+#include "mcu.h"
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+struct sim_src {
+	const char*	name;
+	sim_fire_fn	fire;
+	sim_time_t	due;
+	int			pos;							// heap slot (-1 = not pending)
+};
+
+		sim_time_t	sim_now;
+		uint32_t	sim_isr_count;
+		uint64_t	sim_event_count;
+static	sim_time_t	sim_end;
+static	jmp_buf		sim_exit;
+static	sim_src		srcs[SIM_MAX_SOURCES];
+static	int			nsrc;
+static	int			heap[SIM_MAX_SOURCES];		// pending sources, earliest first
+static	int			nheap;
+static	int			in_isr;
+
+//-----------------------------------------------------------------------------
+// event queue: binary min-heap on (due, source).  Ties go to the source
+//	registered first so that runs are repeatable.
+//-----------------------------------------------------------------------------
+static inline int earlier(int a, int b){
+
+	if(srcs[a].due != srcs[b].due) return srcs[a].due < srcs[b].due;
+	return a < b;
+}
+
+static inline void heap_put(int i, int s){
+
+	heap[i] = s;
+	srcs[s].pos = i;
+}
+
+static void sift_up(int i){
+	int	s = heap[i];
+	int	p;
+
+	while(i > 0){
+		p = (i - 1) >> 1;
+		if(!earlier(s, heap[p])) break;
+		heap_put(i, heap[p]);
+		i = p;
+	}
+	heap_put(i, s);
+}
+
+static void sift_down(int i){
+	int	s = heap[i];
+	int	c;
+
+	while((c = 2 * i + 1) < nheap){
+		if((c + 1 < nheap) && earlier(heap[c + 1], heap[c])) c++;
+		if(!earlier(heap[c], s)) break;
+		heap_put(i, heap[c]);
+		i = c;
+	}
+	heap_put(i, s);
+}
+
+static void heap_remove(int s){
+	int	i = srcs[s].pos;
+
+	srcs[s].pos = -1;
+	if(--nheap == i) return;
+	heap_put(i, heap[nheap]);
+	sift_up(i);
+	sift_down(srcs[heap[i]].pos);
+}
+
+//-----------------------------------------------------------------------------
+// sim_reset() empties the queue for another run in the same process
+//-----------------------------------------------------------------------------
+void sim_reset(void){
+
+	nsrc = 0;
+	nheap = 0;
+	in_isr = 0;
+	sim_now = 0;
+	sim_isr_count = 0;
+	sim_event_count = 0;
+}
+
+//-----------------------------------------------------------------------------
+// sim_source() registers an event source, returns its handle
+//-----------------------------------------------------------------------------
+int sim_source(const char* name, sim_fire_fn fn){
+
+	if(nsrc >= SIM_MAX_SOURCES) sim_fatal("too many event sources");
+	srcs[nsrc].name = name;
+	srcs[nsrc].fire = fn;
+	srcs[nsrc].due = SIM_NEVER;
+	srcs[nsrc].pos = -1;
+	return nsrc++;
+}
+
+//-----------------------------------------------------------------------------
+// sim_schedule() sets (or cancels, with SIM_NEVER) the next due time of src
+//-----------------------------------------------------------------------------
+void sim_schedule(int src, sim_time_t at){
+	sim_src*	p = &srcs[src];
+
+	if(at < sim_now) at = sim_now;
+	if(at == SIM_NEVER){
+		p->due = SIM_NEVER;
+		if(p->pos >= 0) heap_remove(src);
+		return;
+	}
+	if(p->pos < 0){
+		p->due = at;
+		heap_put(nheap, src);
+		sift_up(nheap++);
+	}else if(at < p->due){
+		p->due = at;
+		sift_up(p->pos);
+	}else{
+		p->due = at;
+		sift_down(p->pos);
+	}
+}
+
+sim_time_t sim_due(int src){
+
+	return srcs[src].due;
+}
+
+//-----------------------------------------------------------------------------
+// service() runs every pending, enabled ISR.  ISRs are not nested: the
+//	firmware uses a single priority level.
+//-----------------------------------------------------------------------------
+static void service(void){
+	int	v;
+	int	guard = 0;
+
+	if(in_isr) return;
+	while((v = mcu_irq_next()) >= 0){
+		in_isr = 1;
+		mcu_irq_enter(v);
+		in_isr = 0;
+		sim_isr_count++;
+		if(++guard > 1000) sim_fatal("ISR does not clear its flag");
+	}
+}
+
+//-----------------------------------------------------------------------------
+// fire_next() advances to the earliest pending event and fires it
+//-----------------------------------------------------------------------------
+static void fire_next(void){
+
+	if(!nheap) sim_fatal("firmware waits with no event pending");
+	if(srcs[heap[0]].due >= sim_end) longjmp(sim_exit, 1);
+	sim_fire();
+	service();
+}
+
+//-----------------------------------------------------------------------------
+// sim_idle() models PCON.IDLE: the CPU sleeps until an ISR has run.  Virtual
+//	time jumps from event to event; nothing runs in between.
+//-----------------------------------------------------------------------------
+void sim_idle(void){
+	uint32_t	n = sim_isr_count;
+
+	if(in_isr) return;
+	service();
+	while(n == sim_isr_count) fire_next();
+}
+
+//-----------------------------------------------------------------------------
+// sim_spin() is one pass of a loop that polls an ISR- or hardware-owned flag
+//	("while(!SPIF);", "while(waittimer);").  The flag cannot change before the
+//	next event, so the pass jumps straight to it.
+//-----------------------------------------------------------------------------
+void sim_spin(void){
+
+	if(in_isr) sim_fatal("ISR waits on a flag");
+	fire_next();
+}
+
+//-----------------------------------------------------------------------------
+// sim_irq_check() is called when an enable bit is set by the firmware
+//-----------------------------------------------------------------------------
+void sim_irq_check(void){
+
+	service();
+}
+
+//-----------------------------------------------------------------------------
+// sim_run() runs the firmware entry point until virtual time "end".
+//	The firmware never returns; the kernel long-jumps back here.
+//-----------------------------------------------------------------------------
+int sim_run(sim_time_t end, void (*entry)(void)){
+
+	sim_end = end;
+	if(setjmp(sim_exit) == 0){
+		entry();
+		return 1;									// firmware returned (should not happen)
+	}
+	sim_now = end;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// sim_ext_begin() hands the event queue to an external CPU model.  ISRs are
+//	then code in that model, so service() and sim_idle() are turned off (the
+//	kernel behaves as if it were always inside an ISR).
+//-----------------------------------------------------------------------------
+void sim_ext_begin(sim_time_t end){
+
+	sim_end = end;
+	in_isr = 1;
+}
+
+//-----------------------------------------------------------------------------
+// sim_next() returns the due time of the earliest pending event
+//-----------------------------------------------------------------------------
+sim_time_t sim_next(void){
+
+	return nheap ? srcs[heap[0]].due : SIM_NEVER;
+}
+
+//-----------------------------------------------------------------------------
+// sim_fire() fires the earliest pending event at its due time
+//-----------------------------------------------------------------------------
+void sim_fire(void){
+	int	s = heap[0];
+
+	sim_now = srcs[s].due;
+	heap_remove(s);
+	srcs[s].due = SIM_NEVER;						// fire() reschedules periodic sources
+	sim_event_count++;
+	srcs[s].fire();
+}
+
+//-----------------------------------------------------------------------------
+// sim_fatal() reports a simulation error and exits
+//-----------------------------------------------------------------------------
+void sim_fatal(const char* msg){
+
+	fprintf(stderr, "gpsdo_sim: %s at t=%.6Lf s\n", msg, sim_seconds(sim_now));
+	exit(2);
+}
@@ -0,0 +1,83 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: kernel.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This is the header file for the virtual-time kernel.
+ *             Time is counted in SYSCLK cycles (24.5 MHz) from MCU reset.
+ *             Firmware code runs in zero virtual time; time only advances
+ *             when the firmware idles (PCON) or polls an ISR-owned flag, and
+ *             then jumps directly to the next pending event.  An
+ *             instruction-set simulator can drive the same event queue in
+ *             place of the native firmware (sim_ext_begin()).
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  sim_reset()
+ *
+ *******************************************************************/
+
+#ifndef SIM_KERNEL_H
+#define SIM_KERNEL_H
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// extern defines
+//------------------------------------------------------------------------------
+
+#define	SIM_SYSCLK		24500000L				// must match SYSCLK in init.h
+#define	SIM_NEVER		INT64_MAX
+#define	SIM_MAX_SOURCES	16
+
+typedef int64_t	sim_time_t;
+typedef void (*sim_fire_fn)(void);
+
+extern sim_time_t	sim_now;					// current virtual time (cycles)
+extern uint32_t		sim_isr_count;				// ISR entries since reset
+extern uint64_t		sim_event_count;			// events fired since reset
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+void sim_reset(void);						// drop all sources, time back to 0
+int sim_source(const char* name, sim_fire_fn fn);
+void sim_schedule(int src, sim_time_t at);
+sim_time_t sim_due(int src);
+
+void sim_idle(void);
+void sim_spin(void);
+void sim_irq_check(void);
+int sim_run(sim_time_t end, void (*entry)(void));
+void sim_fatal(const char* msg);
+
+// external CPU (instruction-set simulator): the caller keeps time and fires
+//	the events itself, native ISR dispatch is off
+void sim_ext_begin(sim_time_t end);
+sim_time_t sim_next(void);
+void sim_fire(void);
+
+//------------------------------------------------------------------------------
+// time conversion
+//------------------------------------------------------------------------------
+
+inline long double sim_seconds(sim_time_t t){
+	return (long double)t / (long double)SIM_SYSCLK;
+}
+
+inline sim_time_t sim_cycles(long double s){	// first cycle at or after s
+	long double c = s * (long double)SIM_SYSCLK;
+	sim_time_t	i = (sim_time_t)c;
+
+	if((long double)i < c) i++;
+	return i;
+}
+
+#endif
@@ -0,0 +1,515 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: mcu.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   Simulated C8051F520 peripherals.  Only the modes that the
+ *             GPSDO firmware configures are modeled:
+ *
+ *             Timer0/1: mode 1 (16 bit) and mode 2 (8-bit auto-reload)
+ *             Timer2:   16-bit auto-reload
+ *             PCA:      SYSCLK, SYSCLK/4 or SYSCLK/12 time base, edge capture
+ *             UART0:    8-bit receive into SBUF0/RI0, TI0 after a byte time
+ *             SPI0:     3-wire master, SPIF a byte time after a SPI0DAT write;
+ *                       the byte is exchanged with the slave the board has
+ *                       selected
+ *             Flash:    FLKEY/PSCTL sequencing on the scratchpad sector
+ *
+ *             Timer periods are derived from the register values that
+ *             Init_Device() writes, so a change in f300_init.c shows up here.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  native ISRs attached at run time, pending mask for gpsdo_iss
+ *    10-17-26 jmh:  SPI0 master
+ *
+ *******************************************************************/
+
+#include <string.h>
+#include "c8051F520.h"
+#include "kernel.h"
+#include "mcu.h"
+#include "cseg.h"
+#include "board.h"
+
+//------------------------------------------------------------------------------
+// interrupt sources that the firmware enables, in 8051 polling order.  The
+//	native ISRs are attached with mcu_set_isr(); the ISS vectors on its own.
+//------------------------------------------------------------------------------
+
+static const uint8_t vectors[] = {
+	INTERRUPT_TIMER0,
+	INTERRUPT_UART0,
+	INTERRUPT_TIMER2,
+	INTERRUPT_SPI0,
+	INTERRUPT_PCA0,
+};
+#define	NUM_VECTORS	(int)sizeof(vectors)
+
+//------------------------------------------------------------------------------
+// local defines
+//------------------------------------------------------------------------------
+
+#define	BIT(reg, n)		((sfr_latch((reg).addr) >> (n)) & 1)
+
+#define	PSWE		0x01
+#define	PSEE		0x02
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+		mcu_stats	mcu_stat;
+
+static	int			src_t0;						// event sources
+static	int			src_t2;
+static	int			src_pca;
+static	int			src_tx;
+static	int			src_spi;
+
+static	sim_time_t	pca_t0;						// PCA time base anchor
+static	uint16_t	pca_base;					// counter value at pca_t0
+static	int			pca_run;					// CR
+static	int			pca_clk;					// SYSCLK cycles per PCA count
+static	uint8_t		pca_hi;						// PCA0H snapshot (latched by a PCA0L read)
+static	uint8_t		pca_hi_latched;
+
+static	uint8_t		uart_rbuf;					// receive side of SBUF0
+static	uint8_t		spi_tbuf;					// byte being shifted out
+static	uint8_t		spi_rbuf;					// receive side of SPI0DAT
+static	uint8_t		flkey;						// FLKEY state (0 = locked, 2 = unlocked)
+static	uint8_t		flash_snap[FLASH_SECTOR];	// sector image when PSWE was set
+static	void		(*isr_fn[16])(void);		// native ISRs by interrupt number
+
+//-----------------------------------------------------------------------------
+// timer clock dividers
+//-----------------------------------------------------------------------------
+static int t01_div(int tmx){
+	uint8_t	ck = sfr_latch(CKCON.addr);
+
+	if(ck & (tmx ? 0x08 : 0x04)) return 1;		// T1M/T0M = SYSCLK
+	switch(ck & 0x03){							// SCA1:0 prescaler
+	case 0:
+		return 12;
+	case 1:
+		return 4;
+	case 2:
+		return 48;
+	default:
+		sim_fatal("timer external clock not modeled");
+	}
+	return 12;
+}
+
+static sim_time_t t0_period(int first){
+	uint8_t		tmod = sfr_latch(TMOD.addr) & 0x03;
+	sim_time_t	n;
+
+	if(tmod == 2){
+		n = first ? 256 - sfr_latch(TL0.addr) : 256 - sfr_latch(TH0.addr);
+	}else if(tmod == 1){
+		n = first ? 65536 - ((sfr_latch(TH0.addr) << 8) | sfr_latch(TL0.addr)) : 65536;
+	}else{
+		sim_fatal("timer0 mode not modeled");
+		n = 0;
+	}
+	return n * t01_div(0);
+}
+
+static int t2_div(void){
+
+	if(sfr_latch(CKCON.addr) & 0x10) return 1;	// T2ML = SYSCLK
+	if(BIT(TMR2CN, 0)) sim_fatal("timer2 external clock not modeled");
+	return 12;
+}
+
+static void t2_restart(void){
+	uint16_t	tmr = (sfr_latch(TMR2H.addr) << 8) | sfr_latch(TMR2L.addr);
+
+	if(BIT(TMR2CN, 2)){
+		sim_schedule(src_t2, sim_now + (65536 - (sim_time_t)tmr) * t2_div());
+	}else{
+		sim_schedule(src_t2, SIM_NEVER);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// event handlers
+//-----------------------------------------------------------------------------
+static void t0_fire(void){
+
+	sfr_set_flag(TCON.addr, 5);					// TF0
+	sfr_load(TL0.addr, sfr_latch(TH0.addr));	// mode 2 reload
+	if(BIT(TCON, 4)) sim_schedule(src_t0, sim_now + t0_period(0));
+}
+
+static void t2_fire(void){
+	uint16_t	rl = (sfr_latch(TMR2RLH.addr) << 8) | sfr_latch(TMR2RLL.addr);
+
+	sfr_set_flag(TMR2CN.addr, 7);				// TF2H
+	sim_schedule(src_t2, sim_now + (65536 - (sim_time_t)rl) * t2_div());
+}
+
+static void tx_fire(void){
+
+	sfr_set_flag(SCON0.addr, 1);				// TI0
+}
+
+static void spi_fire(void){
+
+	spi_rbuf = board_spi(spi_tbuf);
+	mcu_stat.spi_bytes++;
+	sfr_clr_flag(SPI0CFG.addr, 7);				// SPIBSY
+	sfr_set_flag(SPI0CN.addr, 7);				// SPIF
+}
+
+//-----------------------------------------------------------------------------
+// SPI0.  The slaves take data on the falling SCK edge and change MISO on the
+//	rising one (CKPOL = 0, CKPHA = 1); a transfer in any other mode, or with
+//	SPI0 off the crossbar, is a firmware bug.
+//-----------------------------------------------------------------------------
+static void spi_start(uint8_t c){
+
+	if(!BIT(SPI0CN, 0) || !BIT(SPI0CFG, 6)) sim_fatal("SPI0 write with SPI0 disabled or not master");
+	if(!(sfr_latch(XBR0.addr) & 0x02)) sim_fatal("SPI0 not on the crossbar");
+	if((sfr_latch(SPI0CFG.addr) & 0x30) != 0x20) sim_fatal("SPI0 clock mode does not match the slaves");
+	if(BIT(SPI0CFG, 7)){
+		sfr_set_flag(SPI0CN.addr, 6);			// WCOL, the byte is ignored
+		mcu_stat.spi_wcol++;
+		return;
+	}
+	spi_tbuf = c;
+	sfr_set_flag(SPI0CFG.addr, 7);
+	sim_schedule(src_spi, sim_now + 16 * ((sim_time_t)sfr_latch(SPI0CKR.addr) + 1));
+}
+
+//-----------------------------------------------------------------------------
+// PCA time base
+//-----------------------------------------------------------------------------
+static int pca_div(void){
+
+	switch((sfr_latch(PCA0MD.addr) >> 1) & 0x07){
+	case 0:
+		return 12;
+	case 1:
+		return 4;
+	case 4:
+		return 1;
+	default:
+		sim_fatal("PCA clock source not modeled");
+	}
+	return 1;
+}
+
+uint16_t mcu_pca_count(void){
+
+	if(!pca_run) return pca_base;
+	return (uint16_t)(pca_base + (sim_now - pca_t0) / pca_clk);
+}
+
+static void pca_anchor(void){					// re-anchor before a clock/run change
+
+	pca_base = mcu_pca_count();
+	pca_t0 = sim_now;
+}
+
+static void pca_overflow_sched(void){
+	sim_time_t	n;
+
+	if(pca_run && (sfr_latch(PCA0MD.addr) & 0x01)){
+		n = (65536 - (sim_time_t)mcu_pca_count()) * pca_clk;
+		n -= (sim_now - pca_t0) % pca_clk;
+		sim_schedule(src_pca, sim_now + n);
+	}else{
+		sim_schedule(src_pca, SIM_NEVER);
+	}
+}
+
+static void pca_fire(void){
+
+	sfr_set_flag(PCA0CN.addr, 7);				// CF
+	pca_overflow_sched();
+}
+
+//-----------------------------------------------------------------------------
+// mcu_cex_edge() is an edge on a PCA capture input
+//-----------------------------------------------------------------------------
+void mcu_cex_edge(int module, int rising){
+	static const uint8_t cpm[] = { PCA0CPM0.addr, PCA0CPM1.addr, PCA0CPM2.addr };
+	static const uint8_t cpl[] = { PCA0CPL0.addr, PCA0CPL1.addr, PCA0CPL2.addr };
+	static const uint8_t cph[] = { PCA0CPH0.addr, PCA0CPH1.addr, PCA0CPH2.addr };
+	uint8_t		mode = sfr_latch(cpm[module]);
+	uint16_t	c;
+
+	if((rising && (mode & 0x20)) || (!rising && (mode & 0x10))){
+		c = mcu_pca_count();
+		sfr_load(cpl[module], (uint8_t)c);		// capture registers
+		sfr_load(cph[module], (uint8_t)(c >> 8));
+		sfr_set_flag(PCA0CN.addr, module);		// CCFn
+	}
+}
+
+//-----------------------------------------------------------------------------
+// mcu_uart_rx() presents one received byte to UART0
+//-----------------------------------------------------------------------------
+void mcu_uart_rx(uint8_t c){
+
+	mcu_stat.uart_rx++;
+	if(!BIT(SCON0, 4)) return;					// REN0 off
+	if(BIT(SCON0, 0)){
+		mcu_stat.uart_overrun++;				// RI0 still set, byte is lost
+		return;
+	}
+	uart_rbuf = c;
+	sfr_set_flag(SCON0.addr, 0);				// RI0
+}
+
+//-----------------------------------------------------------------------------
+// flash controller.  A MOVX write while PSWE is set programs (or, with PSEE,
+//	erases) flash.  The write itself is a plain store into the host image, so
+//	the sector is snapshotted when PSWE goes high and the store is resolved
+//	when PSWE drops: programming can only clear bits, an erase fills with 0xff.
+//-----------------------------------------------------------------------------
+static void flash_commit(uint8_t psctl){
+	uint8_t*	sect = cseg_ptr(FLASH_START);
+	int			i;
+	int			n = 0;
+
+	for(i=0; i<FLASH_SECTOR; i++){
+		if(sect[i] != flash_snap[i]) n++;
+	}
+	if(!n && !(psctl & PSEE)) return;
+	if(flkey != 2){
+		memcpy(sect, flash_snap, FLASH_SECTOR);	// target would reset here
+		mcu_stat.flash_key_errors++;
+	}else if(psctl & PSEE){
+		memset(sect, 0xff, FLASH_SECTOR);
+		mcu_stat.flash_erases++;
+	}else{
+		for(i=0; i<FLASH_SECTOR; i++){
+			sect[i] &= flash_snap[i];
+		}
+		mcu_stat.flash_writes += n;
+	}
+	flkey = 0;									// one operation per unlock
+}
+
+//-----------------------------------------------------------------------------
+// mcu_read() returns the CPU view of an SFR
+//-----------------------------------------------------------------------------
+uint8_t mcu_read(uint8_t addr, uint8_t latch){
+	uint16_t	c;
+
+	switch(addr){
+	case PCA0L.addr:
+		c = mcu_pca_count();
+		pca_hi = c >> 8;
+		pca_hi_latched = 1;
+		return (uint8_t)c;
+	case PCA0H.addr:
+		if(pca_hi_latched){
+			pca_hi_latched = 0;
+			return pca_hi;
+		}
+		return mcu_pca_count() >> 8;
+	case SBUF0.addr:
+		return uart_rbuf;
+	case SPI0DAT.addr:
+		return spi_rbuf;
+	case FLKEY.addr:
+		return flkey;
+	default:
+		return latch;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// mcu_write() applies the side effects of an SFR write
+//-----------------------------------------------------------------------------
+void mcu_write(uint8_t addr, uint8_t old, uint8_t val){
+	uint8_t	chg = old ^ val;
+
+	switch(addr){
+	case PCON.addr:
+		if(val & 0x02) sim_fatal("STOP mode entered");
+		if(val & 0x01){
+			sim_idle();
+			sfr_clr_flag(PCON.addr, 0);			// IDLE clears on wake
+		}
+		break;
+	case TCON.addr:
+		if(chg & 0x10){							// TR0
+			sim_schedule(src_t0, (val & 0x10) ? sim_now + t0_period(1) : SIM_NEVER);
+		}
+		break;
+	case TMR2CN.addr:
+		if(chg & 0x04) t2_restart();
+		break;
+	case TMR2L.addr:
+	case TMR2H.addr:
+	case CKCON.addr:
+		t2_restart();
+		break;
+	case PCA0CN.addr:
+		if(chg & 0x40){							// CR
+			pca_anchor();
+			pca_run = (val & 0x40) != 0;
+			pca_overflow_sched();
+		}
+		break;
+	case PCA0MD.addr:
+		pca_anchor();							// count up to now with the old clock
+		pca_clk = pca_div();
+		pca_overflow_sched();
+		break;
+	case SBUF0.addr:
+		sim_schedule(src_tx, sim_now + 20 * (256 - (sim_time_t)sfr_latch(TH1.addr)) * t01_div(1));
+		break;
+	case SPI0DAT.addr:
+		spi_start(val);
+		break;
+	case FLKEY.addr:
+		if((flkey == 0) && (val == 0xa5)) flkey = 1;
+		else if((flkey == 1) && (val == 0xf1)) flkey = 2;
+		else flkey = 3;							// locked until reset
+		break;
+	case PSCTL.addr:
+		if((val & PSWE) && !(old & PSWE)) memcpy(flash_snap, cseg_ptr(FLASH_START), FLASH_SECTOR);
+		if((old & PSWE) && !(val & PSWE)) flash_commit(old);
+		break;
+	case IE.addr:
+	case EIE1.addr:
+		if(val & chg) sim_irq_check();			// newly enabled
+		break;
+	default:
+		break;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// interrupt controller
+//-----------------------------------------------------------------------------
+static int irq_pending(uint8_t num){
+
+	switch(num){
+	case INTERRUPT_TIMER0:
+		return BIT(TCON, 5) && BIT(IE, 1);
+	case INTERRUPT_UART0:
+		return (BIT(SCON0, 0) || BIT(SCON0, 1)) && BIT(IE, 4);
+	case INTERRUPT_TIMER2:
+		return (BIT(TMR2CN, 7) || (BIT(TMR2CN, 6) && BIT(TMR2CN, 5))) && BIT(IE, 5);
+	case INTERRUPT_SPI0:
+		return (sfr_latch(SPI0CN.addr) & 0xf0) && BIT(IE, 6);
+	case INTERRUPT_PCA0:
+		if(!BIT(EIE1, 2)) return 0;
+		return (BIT(PCA0CN, 7) && BIT(PCA0MD, 0)) ||
+			(BIT(PCA0CN, 0) && BIT(PCA0CPM0, 0)) ||
+			(BIT(PCA0CN, 1) && BIT(PCA0CPM1, 0)) ||
+			(BIT(PCA0CN, 2) && BIT(PCA0CPM2, 0));
+	default:
+		return 0;
+	}
+}
+
+static int irq_high(uint8_t num){
+
+	if(num < 7) return BIT(IP, num);
+	return BIT(EIP1, num - 7);
+}
+
+//-----------------------------------------------------------------------------
+// mcu_irq_pending() returns the requests that are flagged and individually
+//	enabled (EA not considered) as a mask of vector table indexes; *hi gets
+//	the high priority subset
+//-----------------------------------------------------------------------------
+unsigned mcu_irq_pending(unsigned* hi){
+	unsigned	pend = 0;
+	int			i;
+
+	*hi = 0;
+	for(i=0; i<NUM_VECTORS; i++){
+		if(irq_pending(vectors[i])){
+			pend |= 1u << i;
+			if(irq_high(vectors[i])) *hi |= 1u << i;
+		}
+	}
+	return pend;
+}
+
+uint8_t mcu_irq_num(int v){
+
+	return vectors[v];
+}
+
+//-----------------------------------------------------------------------------
+// mcu_irq_next() returns the vector table index to service next, or -1.
+//	High priority requests win, then vector table (polling) order.
+//-----------------------------------------------------------------------------
+int mcu_irq_next(void){
+	unsigned	pend;
+	unsigned	hi;
+
+	if(!BIT(IE, 7)) return -1;					// EA
+	pend = mcu_irq_pending(&hi);
+	if(!pend) return -1;
+	return __builtin_ctz(hi ? hi : pend);
+}
+
+//-----------------------------------------------------------------------------
+// mcu_irq_ack() is the hardware side of vectoring, mcu_irq_enter() also runs
+//	the native ISR
+//-----------------------------------------------------------------------------
+void mcu_irq_ack(int v){
+
+	if(vectors[v] == INTERRUPT_TIMER0) sfr_clr_flag(TCON.addr, 5);	// TF0 clears on vectoring
+	mcu_stat.isr[vectors[v]]++;
+}
+
+void mcu_irq_enter(int v){
+
+	mcu_irq_ack(v);
+	if(!isr_fn[vectors[v]]) sim_fatal("no ISR attached");
+	isr_fn[vectors[v]]();
+}
+
+void mcu_set_isr(uint8_t num, void (*isr)(void)){
+
+	isr_fn[num] = isr;
+}
+
+//-----------------------------------------------------------------------------
+// mcu_init() registers the SFR hooks and the peripheral event sources
+//-----------------------------------------------------------------------------
+void mcu_init(void){
+
+	static const uint8_t rd_hooks[] = { PCA0L.addr, PCA0H.addr, SBUF0.addr, SPI0DAT.addr, FLKEY.addr };
+	static const uint8_t wr_hooks[] = { PCON.addr, TCON.addr, TMR2CN.addr, TMR2L.addr, TMR2H.addr,
+		CKCON.addr, PCA0CN.addr, PCA0MD.addr, SBUF0.addr, SPI0DAT.addr, FLKEY.addr, PSCTL.addr, IE.addr,
+		EIE1.addr };
+	unsigned	i;
+
+	for(i=0; i<sizeof(rd_hooks); i++) sfr_set_hook(rd_hooks[i], SFR_RD);
+	for(i=0; i<sizeof(wr_hooks); i++) sfr_set_hook(wr_hooks[i], SFR_WR);
+	memset(&mcu_stat, 0, sizeof(mcu_stat));
+	src_t0 = sim_source("timer0", t0_fire);
+	src_t2 = sim_source("timer2", t2_fire);
+	src_pca = sim_source("pca", pca_fire);
+	src_tx = sim_source("uart tx", tx_fire);
+	src_spi = sim_source("spi0", spi_fire);
+	pca_t0 = 0;
+	pca_base = 0;
+	pca_run = 0;
+	pca_clk = pca_div();
+	pca_hi_latched = 0;
+	uart_rbuf = 0;
+	spi_tbuf = 0;
+	spi_rbuf = 0;
+	flkey = 0;
+	memset(isr_fn, 0, sizeof(isr_fn));
+}
@@ -0,0 +1,65 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: mcu.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This is the header file for the simulated F520 on-chip
+ *             peripherals (timers, PCA, UART, SPI, flash controller) and the
+ *             interrupt vector table.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  SPI0 counters
+ *
+ *******************************************************************/
+
+#ifndef SIM_MCU_H
+#define SIM_MCU_H
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// extern defines
+//------------------------------------------------------------------------------
+
+#define	PCA_GPS		0						// CEX0 = GPS time pulse
+#define	PCA_FAN		1						// CEX1 = fan PWM
+#define	PCA_DIV		2						// CEX2 = VCO divider time pulse
+
+struct mcu_stats {
+	uint32_t	uart_rx;					// bytes presented to the UART
+	uint32_t	uart_overrun;				// bytes lost because RI0 was still set
+	uint32_t	spi_bytes;					// bytes shifted by SPI0
+	uint32_t	spi_wcol;					// SPI0DAT writes while busy
+	uint32_t	flash_writes;				// bytes programmed
+	uint32_t	flash_erases;				// sector erases
+	uint32_t	flash_key_errors;			// writes without a valid FLKEY sequence
+	uint32_t	isr[16];					// ISR entries per vector
+};
+
+extern mcu_stats mcu_stat;
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+void mcu_init(void);
+uint8_t mcu_read(uint8_t addr, uint8_t latch);
+void mcu_write(uint8_t addr, uint8_t old, uint8_t val);
+int mcu_irq_next(void);
+unsigned mcu_irq_pending(unsigned* hi);
+uint8_t mcu_irq_num(int v);
+void mcu_irq_ack(int v);
+void mcu_irq_enter(int v);
+void mcu_set_isr(uint8_t num, void (*isr)(void));
+void mcu_cex_edge(int module, int rising);
+void mcu_uart_rx(uint8_t c);
+uint16_t mcu_pca_count(void);
+
+#endif
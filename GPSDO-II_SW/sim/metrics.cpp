@@ -0,0 +1,220 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: metrics.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   Loop performance metrics.  The phase error of a divider rising
+ *             edge is its offset from the nearest GPS second; the steady
+ *             state figures cover the last quarter of the run.  The loop
+ *             mode is read from blinkpwm, which main() sets on each VCO
+ *             state change (in TRACK it is the lock quality, under BLINK_50),
+ *             and the lock quality from the PPMFAIR/PPMGOOD flags.  The
+ *             holdover error is the phase change between the last edge
+ *             before and the last edge during a GPS outage.
+ *             The time marks the firmware did not use (degraded accEst,
+ *             outliers) are read from its counters.
+ *             The settle time is the first edge from which the oscillator
+ *             stays within settle.y of the GPS frequency to the end of the run.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  settle time; sim_adev
+ *    10-17-26 jmh:  DAC excursion from the first VCO_TRACK on
+ *    10-17-26 jmh:  fw_tm2_degraded, fw_tm2_outliers
+ *    10-17-26 jmh:  lock quality: time_to_good_s, ss_good_pct, trace lock column
+ *
+ *******************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include "kernel.h"
+#include "config.h"
+#include "mcu.h"
+#include "plant.h"
+#include "ublox.h"
+#include "ad5761.h"
+#include "metrics.h"
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+		sim_metrics	sim_metric;
+		const volatile uint8_t*	sim_blinkpwm;	// firmware blinkpwm, cflag (0 = not visible)
+		const volatile uint8_t*	sim_cflag;
+		const uint16_t*	sim_acc_ndeg;		// firmware reject counts (0 = not visible)
+		const uint16_t*	sim_acc_nrej;
+		adev_state*	sim_adev;
+
+static	double		t_ss;					// start of the steady-state window
+static	long double	sx;						// steady-state sums
+static	long double	sxx;
+static	long double	syy;
+static	double		ho_x0;					// phase at the outage start/end
+static	double		ho_x1;
+static	double		ad_last;				// unwrapped phase to sim_adev, ns
+static	double		ad_off;
+static	FILE*		trace;
+
+static const char* const mode_name[] = { "init", "aqs", "track", "dr" };
+static const char* const lock_name[] = { "none", "fair", "good" };
+
+// firmware cflag bits (init.h)
+#define	FW_PPMFAIR	0x40
+#define	FW_PPMGOOD	0x80
+
+//-----------------------------------------------------------------------------
+// metrics_mode() decodes blinkpwm (BLINK_50 = AQS, BLINK_100 = DR, TRACK is
+//	1 to BLINK_50 - 1, or 0 with PPMGOOD)
+//-----------------------------------------------------------------------------
+int metrics_mode(void){
+	int	b = sim_blinkpwm ? *sim_blinkpwm : 0;
+
+	if(b == 50) return MODE_AQS;
+	if(b == 100) return MODE_DR;
+	if((b > 0) && (b < 50)) return MODE_TRACK;
+	if((b == 0) && (metrics_lock() == LOCK_GOOD)) return MODE_TRACK;
+	return MODE_INIT;
+}
+
+//-----------------------------------------------------------------------------
+// metrics_lock() decodes the PPMFAIR/PPMGOOD flags
+//-----------------------------------------------------------------------------
+int metrics_lock(void){
+	int	c = sim_cflag ? *sim_cflag : 0;
+
+	if(c & FW_PPMGOOD) return LOCK_GOOD;
+	if(c & FW_PPMFAIR) return LOCK_FAIR;
+	return LOCK_NONE;
+}
+
+//-----------------------------------------------------------------------------
+// metrics_init() opens the trace (if any), returns 0 if OK
+//-----------------------------------------------------------------------------
+int metrics_init(double t_end){
+
+	memset(&sim_metric, 0, sizeof(sim_metric));
+	sim_metric.t_track = -1.0;
+	sim_metric.t_settle = 0.0;
+	sim_metric.t_good = -1.0;
+	t_ss = 0.75 * t_end;
+	sx = 0.0L;
+	sxx = 0.0L;
+	syy = 0.0L;
+	ad_last = 0.0;
+	ad_off = 0.0;
+	ho_x0 = NAN;
+	ho_x1 = NAN;
+	sim_metric.holdover_err = NAN;
+	trace = 0;
+	if(sim_cfg.trace[0]){
+		trace = fopen(sim_cfg.trace, "w");
+		if(!trace) return -1;
+		fprintf(trace, "t_s,mode,dac,y,phase_ns,temp_c,lock\n");
+	}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// metrics_edge() is called at each divider rising edge
+//-----------------------------------------------------------------------------
+void metrics_edge(long double t){
+	long double	g = ublox_gps_time(t);
+	double		x = (double)((g - roundl(g)) * 1e9L);
+	double		y = (double)plant_y();
+	int			mode = metrics_mode();
+	int			lock = metrics_lock();
+
+	sim_metric.edges++;
+	if((lock == LOCK_GOOD) && (sim_metric.t_good < 0.0)) sim_metric.t_good = (double)t;
+	if((mode == MODE_TRACK) && (sim_metric.t_track < 0.0)){
+		sim_metric.t_track = (double)t;
+		sim_metric.dac_lo = ad5761_stat.code;
+		sim_metric.dac_hi = ad5761_stat.code;
+	}
+	if(sim_metric.t_track >= 0.0){
+		if(ad5761_stat.code < sim_metric.dac_lo) sim_metric.dac_lo = ad5761_stat.code;
+		if(ad5761_stat.code > sim_metric.dac_hi) sim_metric.dac_hi = ad5761_stat.code;
+	}
+	if(fabs(y) > sim_cfg.settle_y) sim_metric.t_settle = -1.0;
+	else if(sim_metric.t_settle < 0.0) sim_metric.t_settle = (double)t;
+	if(sim_cfg.gps_loss_at >= 0.0){
+		if(t < sim_cfg.gps_loss_at) ho_x0 = x;
+		else if(t < sim_cfg.gps_loss_at + sim_cfg.gps_loss_len) ho_x1 = x;
+	}
+	if(t >= t_ss){
+		sim_metric.ss_n++;
+		if(lock == LOCK_GOOD) sim_metric.ss_good++;
+		sx += x;
+		sxx += (long double)x * x;
+		syy += (long double)y * y;
+		if(sim_adev){
+			// the loop holds frequency, not phase: unwrap across the half second
+			if(sim_metric.ss_n > 1) ad_off -= 1e9 * floor((x + ad_off - ad_last) / 1e9 + 0.5);
+			ad_last = x + ad_off;
+			adev_add(sim_adev, ad_last * 1e-9);
+		}
+	}
+	if(trace) fprintf(trace, "%.9Lf,%s,%u,%.4e,%.3f,%.3f,%s\n", t, mode_name[mode], ad5761_stat.code, y, x,
+		plant_sensor_temp(), lock_name[lock]);
+}
+
+//-----------------------------------------------------------------------------
+// metrics_done() closes the run
+//-----------------------------------------------------------------------------
+void metrics_done(void){
+	long double	n = sim_metric.ss_n;
+	long double	v;
+
+	if(n > 0){
+		sim_metric.phase_mean = (double)(sx / n);
+		v = sxx / n - (sx / n) * (sx / n);
+		sim_metric.phase_rms = (double)sqrtl(v > 0.0L ? v : 0.0L);
+		sim_metric.y_rms = (double)sqrtl(syy / n);
+	}
+	sim_metric.holdover_err = ho_x1 - ho_x0;
+	if(trace) fclose(trace);
+	trace = 0;
+}
+
+void metrics_report(FILE* fp){
+
+	fprintf(fp, "sim_hours         %.3f\n", (double)sim_seconds(sim_now) / 3600.0);
+	fprintf(fp, "final_mode        %s\n", mode_name[metrics_mode()]);
+	fprintf(fp, "time_to_track_s   %.1f\n", sim_metric.t_track);
+	fprintf(fp, "settle_s          %.1f\n", sim_metric.t_settle);
+	fprintf(fp, "final_lock        %s\n", lock_name[metrics_lock()]);
+	fprintf(fp, "time_to_good_s    %.1f\n", sim_metric.t_good);
+	fprintf(fp, "div_edges         %u\n", sim_metric.edges);
+	fprintf(fp, "ss_edges          %u\n", sim_metric.ss_n);
+	fprintf(fp, "ss_phase_mean_ns  %.3f\n", sim_metric.phase_mean);
+	fprintf(fp, "ss_phase_rms_ns   %.3f\n", sim_metric.phase_rms);
+	fprintf(fp, "ss_good_pct       %.1f\n",
+		sim_metric.ss_n ? 100.0 * sim_metric.ss_good / sim_metric.ss_n : 0.0);
+	fprintf(fp, "ss_y_rms          %.4e\n", sim_metric.y_rms);
+	fprintf(fp, "final_y           %.4e\n", (double)plant_y());
+	fprintf(fp, "holdover_err_ns   %.3f\n", sim_metric.holdover_err);
+	fprintf(fp, "dac_writes        %u\n", ad5761_stat.updates);
+	fprintf(fp, "dac_final         %u\n", ad5761_stat.code);
+	fprintf(fp, "dac_min           %u\n", ad5761_stat.code_min);
+	fprintf(fp, "dac_max           %u\n", ad5761_stat.code_max);
+	fprintf(fp, "dac_excursion     %u\n", sim_metric.dac_hi - sim_metric.dac_lo);
+	fprintf(fp, "flash_writes      %u\n", mcu_stat.flash_writes);
+	fprintf(fp, "flash_erases      %u\n", mcu_stat.flash_erases);
+	fprintf(fp, "uart_bytes        %u\n", mcu_stat.uart_rx);
+	fprintf(fp, "uart_overruns     %u\n", mcu_stat.uart_overrun);
+	fprintf(fp, "gps_tm2_frames    %u\n", ublox_stat.tm2);
+	fprintf(fp, "gps_tm2_dropped   %u\n", ublox_stat.tm2_dropped);
+	fprintf(fp, "gps_tm2_degraded  %u\n", ublox_stat.tm2_degraded);
+	fprintf(fp, "gps_tm2_glitch    %u\n", ublox_stat.tm2_glitch);
+	fprintf(fp, "fw_tm2_degraded   %u\n", sim_acc_ndeg ? *sim_acc_ndeg : 0);
+	fprintf(fp, "fw_tm2_outliers   %u\n", sim_acc_nrej ? *sim_acc_nrej : 0);
+	fprintf(fp, "gps_bytes_corrupt %u\n", ublox_stat.corrupted);
+	fprintf(fp, "isr_entries       %u\n", sim_isr_count);
+}
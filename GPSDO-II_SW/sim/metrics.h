@@ -0,0 +1,79 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: metrics.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This is the header file for the loop performance metrics
+ *             collected at each divider rising edge.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  settle time; steady-state phase to an ADEV engine
+ *    10-17-26 jmh:  DAC excursion in track
+ *    10-17-26 jmh:  firmware time-mark reject counts
+ *    10-17-26 jmh:  lock quality (PPMFAIR/PPMGOOD), TRACK mode from any blinkpwm under BLINK_50
+ *
+ *******************************************************************/
+
+#ifndef SIM_METRICS_H
+#define SIM_METRICS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "adev.h"
+
+//------------------------------------------------------------------------------
+// extern defines
+//------------------------------------------------------------------------------
+
+// loop mode as shown by the ERROR LED duty cycle (blinkpwm)
+#define	MODE_INIT	0
+#define	MODE_AQS	1
+#define	MODE_TRACK	2
+#define	MODE_DR		3
+
+// lock quality (firmware cflag PPMFAIR/PPMGOOD)
+#define	LOCK_NONE	0
+#define	LOCK_FAIR	1
+#define	LOCK_GOOD	2
+
+struct sim_metrics {
+	uint32_t	edges;						// divider rising edges
+	double		t_track;					// first entry to VCO_TRACK, s (< 0 = never)
+	double		t_settle;					// |y| within settle.y from here on, s (< 0 = never)
+	double		t_good;						// first PPMGOOD, s (< 0 = never)
+	uint32_t	ss_good;					// steady-state edges with PPMGOOD
+	uint16_t	dac_lo;						// DAC range at the edges from t_track on
+	uint16_t	dac_hi;
+	uint32_t	ss_n;						// edges in the steady-state window
+	double		phase_mean;					// steady state (last quarter of the run)
+	double		phase_rms;					// ns, about the mean
+	double		y_rms;						// fractional frequency
+	double		holdover_err;				// phase change over the GPS outage, ns (NAN = none)
+};
+
+extern sim_metrics sim_metric;
+extern const volatile uint8_t* sim_blinkpwm;	// set by the runner (main.c blinkpwm, cflag)
+extern const volatile uint8_t* sim_cflag;
+extern const uint16_t* sim_acc_ndeg;		// set by the runner (main.c acc_ndeg, acc_nrej)
+extern const uint16_t* sim_acc_nrej;
+extern adev_state* sim_adev;				// if set, fed the steady-state edge phase
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+int metrics_init(double t_end);
+void metrics_edge(long double t);
+void metrics_done(void);
+void metrics_report(FILE* fp);
+int metrics_mode(void);
+int metrics_lock(void);
+
+#endif
@@ -0,0 +1,251 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: plant.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   OCXO/VCO and divider chain.  The fractional frequency offset
+ *             of the VCO is
+ *
+ *               y = slope * (code - null_dac)                tuning
+ *                 + age1 * d + age2 * d^2                    aging, d = days
+ *                 + tempco * (T - tref)                      enclosure temp
+ *                 + y_wfm + y_ffm + y_rwfm                   power-law noise
+ *
+ *             where code is the tuning voltage expressed in LSBs of the
+ *             0-5V DAC range (DAC_CONFIG selects RA_3) and T is the
+ *             enclosure temperature that the DS1722 reads.
+ *
+ *             The noise, aging and thermal terms are updated every osc.dt
+ *             seconds and the tuning term whenever the DAC output changes,
+ *             so y is piecewise constant.  VCO phase is kept in cycles (long
+ *             double) and integrated across each piece, which places every
+ *             divider edge at the exact time its VCO cycle occurs; the PCA
+ *             sees it at the next SYSCLK cycle.  White PM (osc.wpm) is added
+ *             to the edge times only.
+ *
+ *             Noise is specified by its ADEV: white FM as sigma(1 s),
+ *             flicker FM as the floor, random walk FM as sigma(1 s).
+ *             Flicker FM is the sum of Ornstein-Uhlenbeck processes with
+ *             equal variance and time constants spaced by FFM_RATIO, which
+ *             gives S_y(f) = h-1/f between the first and last corner.
+ *
+ *             The enclosure is a single thermal mass:
+ *               dT/dt = (Tamb - T) / tau + tec * drive
+ *             with drive = +1/-1/0 from the TEC H-bridge pins.  Tamb is temp,
+ *             plus temp.step from temp.step_at on.
+ *
+ *             While DIV_RST is high the divider is held with its output low.
+ *             After release the output rises every N = f0 * div.period VCO
+ *             cycles (first rise one full period after release) and falls
+ *             half way between.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  aging, tempco, thermal model and power-law noise
+ *    10-17-26 jmh:  ambient temperature step
+ *
+ *******************************************************************/
+
+#include <math.h>
+#include "kernel.h"
+#include "config.h"
+#include "rng.h"
+#include "mcu.h"
+#include "board.h"
+#include "plant.h"
+#include "ublox.h"
+#include "metrics.h"
+
+//------------------------------------------------------------------------------
+// local defines
+//------------------------------------------------------------------------------
+
+#define	DAC_FS_VOLTS	5.0					// RA_3
+#define	SEC_PER_DAY		86400.0
+#define	FFM_POLES		12					// flicker FM: OU processes...
+#define	FFM_RATIO		4.0					// ...with tau = dt * FFM_RATIO^k
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+static	int			src_div;
+static	int			src_step;
+static	sim_rng		rng;
+
+static	long double	freq;					// VCO frequency, Hz
+static	long double	ph_t;					// phase reference time, s
+static	long double	ph;						// VCO phase at ph_t, cycles
+static	double		y_tune;					// frequency offset terms
+static	double		y_age;
+static	double		y_temp;
+static	double		y_wfm;
+static	double		y_rwfm;
+static	double		y_ffm[FFM_POLES];
+static	double		ffm_a[FFM_POLES];		// OU step coefficients
+static	double		ffm_b[FFM_POLES];
+static	double		temp;					// enclosure temperature, C
+static	int64_t		nstep;					// update steps done
+
+static	long double	half_n;					// VCO cycles per divider half period
+static	int			div_run;
+static	long double	ph_rel;					// VCO phase at divider release
+static	int64_t		hidx;					// next edge = ph_rel + hidx * half_n
+static	long double	t_edge;					// exact time of the next edge
+static	int			div_out;				// divider output level
+
+//-----------------------------------------------------------------------------
+// phase bookkeeping
+//-----------------------------------------------------------------------------
+static long double phase_at(long double t){
+
+	return ph + freq * (t - ph_t);
+}
+
+static void div_sched(void){
+
+	if(!div_run){
+		sim_schedule(src_div, SIM_NEVER);
+		return;
+	}
+	t_edge = ph_t + (ph_rel + (long double)hidx * half_n - ph) / freq;
+	sim_schedule(src_div, sim_cycles(t_edge));
+}
+
+//-----------------------------------------------------------------------------
+// set_freq() closes the current constant-frequency piece at the present
+//	time and starts the next one
+//-----------------------------------------------------------------------------
+static void set_freq(void){
+	long double	t = sim_seconds(sim_now);
+	double		y = y_tune + y_age + y_temp + y_wfm + y_rwfm;
+	int			i;
+
+	for(i=0; i<FFM_POLES; i++) y += y_ffm[i];
+	ph = phase_at(t);
+	ph_t = t;
+	freq = (long double)sim_cfg.osc_f0 * (1.0L + (long double)y);
+	div_sched();
+}
+
+//-----------------------------------------------------------------------------
+// div_fire() is a divider output edge
+//-----------------------------------------------------------------------------
+static void div_fire(void){
+	long double	t = t_edge;
+
+	if(sim_cfg.osc_wpm > 0.0) t += sim_cfg.osc_wpm * rng_gauss(&rng);
+	div_out = !(hidx & 1);						// even index = rising
+	mcu_cex_edge(PCA_DIV, div_out);
+	ublox_mark(t, div_out);
+	if(div_out) metrics_edge(t);
+	hidx++;
+	div_sched();
+}
+
+//-----------------------------------------------------------------------------
+// step_fire() advances the aging, thermal and noise terms by osc.dt
+//-----------------------------------------------------------------------------
+static void step_fire(void){
+	double	dt = sim_cfg.osc_dt;
+	double	d;
+	double	amb;
+	int		i;
+
+	nstep++;
+	d = (double)nstep * dt / SEC_PER_DAY;
+	y_age = sim_cfg.osc_age1 * d + sim_cfg.osc_age2 * d * d;
+	amb = sim_cfg.temp;
+	if((sim_cfg.temp_step_at >= 0.0) && ((double)nstep * dt >= sim_cfg.temp_step_at)) amb += sim_cfg.temp_step;
+	temp += dt * ((amb - temp) / sim_cfg.temp_tau + sim_cfg.temp_tec * board_tec());
+	y_temp = sim_cfg.osc_tempco * (temp - sim_cfg.osc_tref);
+	y_wfm = sim_cfg.osc_wfm / sqrt(dt) * rng_gauss(&rng);
+	y_rwfm += sim_cfg.osc_rwfm * sqrt(3.0 * dt) * rng_gauss(&rng);
+	for(i=0; i<FFM_POLES; i++) y_ffm[i] = ffm_a[i] * y_ffm[i] + ffm_b[i] * rng_gauss(&rng);
+	set_freq();
+	sim_schedule(src_step, sim_cycles((long double)(nstep + 1) * dt));
+}
+
+//-----------------------------------------------------------------------------
+// plant_vtune() applies a new tuning voltage at the current time
+//-----------------------------------------------------------------------------
+void plant_vtune(double volts){
+
+	y_tune = sim_cfg.osc_slope * (volts * 65536.0 / DAC_FS_VOLTS - sim_cfg.osc_null_dac);
+	set_freq();
+}
+
+long double plant_y(void){
+
+	return freq / (long double)sim_cfg.osc_f0 - 1.0L;
+}
+
+double plant_sensor_temp(void){
+
+	return temp;
+}
+
+//-----------------------------------------------------------------------------
+// plant_div_reset() follows DIV_RST
+//-----------------------------------------------------------------------------
+void plant_div_reset(int rst){
+	long double	t = sim_seconds(sim_now);
+
+	if(rst){
+		if(!div_run) return;
+		div_run = 0;
+		if(div_out){							// reset forces the output low
+			div_out = 0;
+			mcu_cex_edge(PCA_DIV, 0);
+			ublox_mark(t, 0);
+		}
+	}else{
+		if(div_run) return;
+		div_run = 1;
+		ph_rel = phase_at(t);
+		hidx = 2;
+	}
+	div_sched();
+}
+
+//-----------------------------------------------------------------------------
+// plant_init() powers up the VCO with 0V on the tuning input.  Each noise
+//	process starts from its stationary distribution.
+//-----------------------------------------------------------------------------
+void plant_init(void){
+	double	dt = sim_cfg.osc_dt;
+	double	v;
+	double	tau;
+	int		i;
+
+	src_div = sim_source("divider", div_fire);
+	src_step = sim_source("ocxo step", step_fire);
+	rng_seed(&rng, sim_cfg.seed, RNG_PLANT);
+	half_n = (long double)sim_cfg.osc_f0 * (long double)sim_cfg.div_period / 2.0L;
+	// flicker FM: h-1 = floor^2 / (2 ln 2), per-pole variance = h-1 * ln(ratio)
+	v = sim_cfg.osc_ffm * sim_cfg.osc_ffm / (2.0 * log(2.0)) * log(FFM_RATIO);
+	for(i=0, tau=dt; i<FFM_POLES; i++, tau*=FFM_RATIO){
+		ffm_a[i] = exp(-dt / tau);
+		ffm_b[i] = sqrt(v * (1.0 - ffm_a[i] * ffm_a[i]));
+		y_ffm[i] = sqrt(v) * rng_gauss(&rng);
+	}
+	y_wfm = 0.0;
+	y_rwfm = 0.0;
+	y_age = 0.0;
+	temp = sim_cfg.temp;
+	y_temp = sim_cfg.osc_tempco * (temp - sim_cfg.osc_tref);
+	nstep = 0;
+	ph = 0.0L;
+	ph_t = 0.0L;
+	div_run = 0;
+	div_out = 0;
+	freq = sim_cfg.osc_f0;
+	plant_vtune(0.0);
+	sim_schedule(src_step, sim_cycles((long double)dt));
+}
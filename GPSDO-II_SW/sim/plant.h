@@ -0,0 +1,34 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: plant.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This is the header file for the controlled plant: the VCO
+ *             (OCXO with tuning input) and the divider chain whose output
+ *             goes to CEX2 and to the GPS receiver time-mark input.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+#ifndef SIM_PLANT_H
+#define SIM_PLANT_H
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+void plant_init(void);
+void plant_vtune(double volts);				// AD5761 output changed
+void plant_div_reset(int rst);				// DIV_RST pin level
+long double plant_y(void);					// fractional frequency offset now
+double plant_sensor_temp(void);				// DS1722 temperature, C
+
+#endif
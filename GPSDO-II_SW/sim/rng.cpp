@@ -0,0 +1,87 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: rng.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   xoshiro256** seeded through splitmix64, normal deviates by
+ *             the polar method.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+#include <math.h>
+#include "rng.h"
+
+//-----------------------------------------------------------------------------
+// local helpers
+//-----------------------------------------------------------------------------
+static uint64_t rotl(uint64_t x, int k){
+
+	return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t splitmix(uint64_t* x){
+	uint64_t	z = (*x += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+//-----------------------------------------------------------------------------
+// rng_seed() sets up stream "stream" of run "seed"
+//-----------------------------------------------------------------------------
+void rng_seed(sim_rng* r, uint64_t seed, uint64_t stream){
+	uint64_t	x = seed * 0x100000001b3ULL + stream;
+	int			i;
+
+	for(i=0; i<4; i++) r->s[i] = splitmix(&x);
+	r->have_g = 0;
+}
+
+uint64_t rng_next(sim_rng* r){
+	uint64_t*	s = r->s;
+	uint64_t	res = rotl(s[1] * 5, 7) * 9;
+	uint64_t	t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+	return res;
+}
+
+double rng_uniform(sim_rng* r){
+
+	return (double)(rng_next(r) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double rng_gauss(sim_rng* r){
+	double	u;
+	double	v;
+	double	q;
+
+	if(r->have_g){
+		r->have_g = 0;
+		return r->g;
+	}
+	do{
+		u = 2.0 * rng_uniform(r) - 1.0;
+		v = 2.0 * rng_uniform(r) - 1.0;
+		q = u * u + v * v;
+	}while((q >= 1.0) || (q == 0.0));
+	q = sqrt(-2.0 * log(q) / q);
+	r->g = v * q;
+	r->have_g = 1;
+	return u * q;
+}
@@ -0,0 +1,51 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: rng.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This is the header file for the simulation random number
+ *             streams.  The generator (xoshiro256**) is implemented here
+ *             rather than taken from <random> so that a given seed gives the
+ *             same run on every host and library version.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *
+ *******************************************************************/
+
+#ifndef SIM_RNG_H
+#define SIM_RNG_H
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// extern defines
+//------------------------------------------------------------------------------
+
+// stream ids: each model draws from its own stream
+#define	RNG_PLANT	1
+#define	RNG_GPS		2
+#define	RNG_MC		3						// gpsdo_mc parameter draws
+
+struct sim_rng {
+	uint64_t	s[4];
+	int			have_g;						// spare normal deviate
+	double		g;
+};
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+void rng_seed(sim_rng* r, uint64_t seed, uint64_t stream);
+uint64_t rng_next(sim_rng* r);
+double rng_uniform(sim_rng* r);				// [0, 1)
+double rng_gauss(sim_rng* r);				// N(0, 1)
+
+#endif
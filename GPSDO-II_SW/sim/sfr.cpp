@@ -0,0 +1,90 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: sfr.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   Host SFR register file.  Hooked port accesses go to the board
+ *             model (board.cpp), other hooked registers to the F520
+ *             peripheral model (mcu.cpp).
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  plain registers are accessed inline, hooks per address
+ *
+ *******************************************************************/
+
+#include <string.h>
+#include "c8051F520.h"
+#include "mcu.h"
+#include "board.h"
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+		uint8_t	sfr_reg[256];
+		uint8_t	sfr_hook[256];
+
+//-----------------------------------------------------------------------------
+// sfr_reset() sets the F520 reset values that the firmware relies on.  The
+//	peripheral and board models register their hooks after this.
+//-----------------------------------------------------------------------------
+void sfr_reset(void){
+
+	memset(sfr_reg, 0, sizeof(sfr_reg));
+	memset(sfr_hook, 0, sizeof(sfr_hook));
+	sfr_reg[P0.addr] = 0xff;
+	sfr_reg[P1.addr] = 0xff;
+	sfr_reg[SP.addr] = 0x07;
+	sfr_reg[PCA0MD.addr] = 0x40;				// watchdog enabled
+	sfr_reg[SPI0CFG.addr] = 0x07;
+	sfr_reg[SPI0CN.addr] = 0x06;
+	sfr_set_hook(P0.addr, SFR_RD | SFR_WR);
+	sfr_set_hook(P1.addr, SFR_RD | SFR_WR);
+}
+
+void sfr_set_hook(uint8_t addr, uint8_t flags){
+
+	sfr_hook[addr] |= flags;
+}
+
+//-----------------------------------------------------------------------------
+// sfr_read_hook() is a CPU read of a hooked register: ports return the pins
+//-----------------------------------------------------------------------------
+uint8_t sfr_read_hook(uint8_t addr){
+
+	switch(addr){
+	case P0.addr:
+		return sfr_reg[addr] & board_pins(0);
+	case P1.addr:
+		return sfr_reg[addr] & board_pins(1);
+	default:
+		return mcu_read(addr, sfr_reg[addr]);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// sfr_write_hook() is a CPU write of a hooked register
+//-----------------------------------------------------------------------------
+void sfr_write_hook(uint8_t addr, uint8_t val){
+	uint8_t	old = sfr_reg[addr];
+
+	sfr_reg[addr] = val;
+	switch(addr){
+	case P0.addr:
+		board_port(0, old, val);
+		break;
+	case P1.addr:
+		board_port(1, old, val);
+		break;
+	default:
+		mcu_write(addr, old, val);
+		break;
+	}
+}
@@ -0,0 +1,123 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: sfr.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This is the header file for the host-side SFR register file.
+ *             sim_sfr and sim_sbit stand in for the Keil "sfr" and "sbit"
+ *             types so that the firmware sources compile unchanged; every
+ *             access is routed through sfr_read()/sfr_write() so that the
+ *             simulated peripherals can see it.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  "!" on a bit keeps its flag type (while(!SPIF);)
+ *
+ *******************************************************************/
+
+#ifndef SIM_SFR_H
+#define SIM_SFR_H
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// Register file access (sfr.cpp).  Registers with side effects are flagged in
+//	sfr_hook[]; all others are plain memory and are accessed inline.
+//-----------------------------------------------------------------------------
+
+#define	SFR_RD		0x01							// read has side effects / is not the latch
+#define	SFR_WR		0x02							// write has side effects
+
+extern uint8_t	sfr_reg[256];						// latches / registers
+extern uint8_t	sfr_hook[256];
+
+uint8_t sfr_read_hook(uint8_t addr);
+void sfr_write_hook(uint8_t addr, uint8_t val);
+void sfr_set_hook(uint8_t addr, uint8_t flags);
+void sfr_reset(void);
+
+inline uint8_t sfr_latch(uint8_t addr){				// raw register/latch value
+	return sfr_reg[addr];
+}
+
+inline void sfr_load(uint8_t addr, uint8_t val){	// hardware load (no write hooks)
+	sfr_reg[addr] = val;
+}
+
+inline void sfr_set_flag(uint8_t addr, uint8_t bitn){
+	sfr_reg[addr] |= (uint8_t)(1 << bitn);
+}
+
+inline void sfr_clr_flag(uint8_t addr, uint8_t bitn){
+	sfr_reg[addr] &= (uint8_t)~(1 << bitn);
+}
+
+inline uint8_t sfr_read(uint8_t addr){				// CPU read (pins for ports)
+	if(sfr_hook[addr] & SFR_RD) return sfr_read_hook(addr);
+	return sfr_reg[addr];
+}
+
+inline void sfr_write(uint8_t addr, uint8_t val){	// CPU write
+	if(sfr_hook[addr] & SFR_WR) sfr_write_hook(addr, val);
+	else sfr_reg[addr] = val;
+}
+
+// bit access (JB/SETB/CLR/CPL).  Bit writes are read-modify-write on the latch.
+inline uint8_t sfr_read_bit(uint8_t addr, uint8_t bitn){
+	return (sfr_read(addr) >> bitn) & 1;
+}
+
+inline void sfr_write_bit(uint8_t addr, uint8_t bitn, uint8_t val){
+	if(val) sfr_write(addr, sfr_reg[addr] | (uint8_t)(1 << bitn));
+	else sfr_write(addr, sfr_reg[addr] & (uint8_t)~(1 << bitn));
+}
+
+//-----------------------------------------------------------------------------
+// sim_sfr: byte-wide special function register
+//-----------------------------------------------------------------------------
+
+struct sim_sfr {
+	uint8_t	addr;
+
+	operator uint8_t() const { return sfr_read(addr); }
+	const sim_sfr& operator=(unsigned v) const { sfr_write(addr, (uint8_t)v); return *this; }
+	// RMW instructions (ANL/ORL/XRL) operate on the latch, not the pins
+	const sim_sfr& operator&=(unsigned v) const { sfr_write(addr, sfr_latch(addr) & (uint8_t)v); return *this; }
+	const sim_sfr& operator|=(unsigned v) const { sfr_write(addr, sfr_latch(addr) | (uint8_t)v); return *this; }
+	const sim_sfr& operator^=(unsigned v) const { sfr_write(addr, sfr_latch(addr) ^ (uint8_t)v); return *this; }
+};
+
+//-----------------------------------------------------------------------------
+// sim_sbit: bit-addressable SFR bit.  Keil treats "~" on a bit as CPL, so
+//	operator~ is a logical complement here.  "!" returns sim_sbit_not so that
+//	keil51.h still sees a hardware flag in "while(!SPIF);".
+//-----------------------------------------------------------------------------
+
+struct sim_sbit_not {
+	uint8_t	addr;
+	uint8_t	bitn;
+
+	operator bool() const { return !sfr_read_bit(addr, bitn); }
+};
+
+struct sim_sbit {
+	uint8_t	addr;
+	uint8_t	bitn;
+
+	operator uint8_t() const { return sfr_read_bit(addr, bitn); }
+	uint8_t operator~() const { return !sfr_read_bit(addr, bitn); }
+	sim_sbit_not operator!() const { return sim_sbit_not{ addr, bitn }; }
+	const sim_sbit& operator=(unsigned v) const { sfr_write_bit(addr, bitn, v != 0); return *this; }
+};
+
+constexpr sim_sbit operator^(sim_sfr reg, int bitn){
+	return sim_sbit{ reg.addr, (uint8_t)bitn };
+}
+
+#endif
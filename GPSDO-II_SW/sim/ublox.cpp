@@ -0,0 +1,466 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: ublox.cpp
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   GPS receiver model.  Simulation time is true (GPS) time:
+ *             the receiver's 1PPS rises on every GPS second and goes to CEX0.
+ *             Edges on the EXTINT input (divider output) are time-stamped
+ *             and reported in a TIM-TM2 frame at the next navigation epoch
+ *             plus gps.tm2_delay, the way the receiver queues it.  Frames go
+ *             out on the UART at 38400 baud, 10 bit times per byte.
+ *
+ *             Before the first fix and during an outage the time pulse stops
+ *             and TIM-TM2 is sent with the time-valid flag clear.
+ *
+ *             Stream options (see config.cpp): receiver clock quantization
+ *             (sawtooth) and timestamp noise, accEst, TIM-TM2 dropouts,
+ *             corrupted bytes, and NMEA, NAV-xxx and TIM-TP traffic mixed in
+ *             around the TIM-TM2 frames the way a receiver interleaves them.
+ *             A degraded-timing window (gps.deg_xxx) reports a larger accEst
+ *             and scales the noise with it; gps.glitch puts single time
+ *             marks off by gps.glitch_size with the accEst unchanged.
+ *
+ *             gps.capture writes the UART stream to a file.  gps.replay sends
+ *             a file (a capture, or a recording of a real receiver) back to
+ *             back at the line rate from power-on in place of the modelled
+ *             traffic; the time pulse is still modelled.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  TIM-TM2 stream generator: sawtooth, dropouts, corruption, mixed traffic
+ *    10-17-26 jmh:  gps.capture / gps.replay
+ *    10-17-26 jmh:  degraded timing window, time-mark glitches
+ *
+ *******************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "kernel.h"
+#include "config.h"
+#include "rng.h"
+#include "mcu.h"
+#include "ublox.h"
+
+//------------------------------------------------------------------------------
+// local defines
+//------------------------------------------------------------------------------
+
+#define	BAUD			38400.0L
+#define	SEC_PER_WEEK	604800LL
+#define	NS_PER_MS		1000000LL
+#define	LEAP_SECONDS	18					// GPS - UTC
+#define	TXQ_LEN			2048				// UART queue (power of 2)
+
+#define	UBX_SYNC1		0xb5
+#define	UBX_SYNC2		0x62
+#define	UBX_NAV			0x01
+#define	UBX_NAV_STATUS	0x03
+#define	UBX_NAV_PVT		0x07
+#define	UBX_TIM			0x0d
+#define	UBX_TIM_TP		0x01
+#define	UBX_TIM_TM2		0x03
+#define	TM2_LEN			28
+#define	TP_LEN			16
+#define	STATUS_LEN		16
+#define	PVT_LEN			92
+
+// TIM-TM2 flags (init.h TMK_xxx)
+#define	TMK_MODE		0x01
+#define	TMK_FE			0x04
+#define	TMK_TB_GNSS		0x08
+#define	TMK_UTC			0x20
+#define	TMK_TVALID		0x40
+#define	TMK_RE			0x80
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+		ublox_stats	ublox_stat;
+
+static	int			src_tp;
+static	int			src_epoch;
+static	int			src_uart;
+static	sim_rng		rng;
+static	long double	gps0;					// GPS time at t = 0
+static	int64_t		sec;					// GPS second of the next epoch
+static	long double	tick;					// receiver clock period, true seconds
+static	long double	tick0;					// receiver clock phase at t = 0
+
+struct tmark {
+	int64_t		ns;							// reported GPS time of the edge, ns
+	int			fresh;						// not yet reported
+};
+static	tmark		mark_r;					// last rising edge
+static	tmark		mark_f;					// last falling edge
+static	uint16_t	mark_count;				// rising edge count
+
+static	uint8_t		txq[TXQ_LEN];
+static	uint32_t	txq_head;
+static	uint32_t	txq_tail;
+static	long double	t_byte;					// exact time of the next byte
+
+static	FILE*		cap;					// gps.capture
+static	uint8_t*	rep;					// gps.replay, whole file
+static	uint32_t	rep_len;
+static	uint32_t	rep_idx;
+static	int			src_replay;
+
+//-----------------------------------------------------------------------------
+// time helpers
+//-----------------------------------------------------------------------------
+long double ublox_gps_time(long double t){
+
+	return gps0 + t;
+}
+
+static long double epoch_time(int64_t s){		// sim time of GPS second s
+
+	return (long double)s - gps0;
+}
+
+int ublox_valid(long double t){
+
+	if(t < sim_cfg.gps_fix) return 0;
+	if((sim_cfg.gps_loss_at >= 0.0) && (t >= sim_cfg.gps_loss_at) &&
+		(t < sim_cfg.gps_loss_at + sim_cfg.gps_loss_len)) return 0;
+	return 1;
+}
+
+//-----------------------------------------------------------------------------
+// receiver clock.  The receiver runs from its own TCXO (gps.quant period,
+//	gps.drift fractional offset); time marks are latched and the time pulse
+//	is produced on its ticks, which gives the quantization sawtooth.
+//-----------------------------------------------------------------------------
+static long double tick_after(long double t){	// first tick at or after t
+
+	return tick0 + ceill((t - tick0) / tick) * tick;
+}
+
+static long double tick_nearest(long double t){
+
+	return tick0 + roundl((t - tick0) / tick) * tick;
+}
+
+static long double tp_time(int64_t s){			// actual time pulse for second s
+
+	return tick_nearest(epoch_time(s));
+}
+
+//-----------------------------------------------------------------------------
+// UART transmit queue.  gps.corrupt is the probability that a byte arrives
+//	with one bit flipped.
+//-----------------------------------------------------------------------------
+static void uart_fire(void){
+	uint8_t	c = txq[txq_tail++ & (TXQ_LEN - 1)];
+
+	if((sim_cfg.gps_corrupt > 0.0) && (rng_uniform(&rng) < sim_cfg.gps_corrupt)){
+		c ^= (uint8_t)(1 << (rng_next(&rng) & 7));
+		ublox_stat.corrupted++;
+	}
+	mcu_uart_rx(c);
+	if(cap) putc(c, cap);
+	ublox_stat.bytes++;
+	if(txq_tail != txq_head){
+		t_byte += 10.0L / BAUD;
+		sim_schedule(src_uart, sim_cycles(t_byte));
+	}
+}
+
+static void uart_send(const uint8_t* p, int n){
+	long double	t = sim_seconds(sim_now);
+
+	if(rep) return;								// the replay owns the line
+	if((txq_head - txq_tail) + n > TXQ_LEN){
+		ublox_stat.tx_overflow++;				// receiver drops output it can't buffer
+		return;
+	}
+	if(txq_head == txq_tail){					// idle line, start now
+		t_byte = t + 10.0L / BAUD;
+		sim_schedule(src_uart, sim_cycles(t_byte));
+	}
+	while(n--) txq[txq_head++ & (TXQ_LEN - 1)] = *p++;
+}
+
+//-----------------------------------------------------------------------------
+// replay_fire() sends the next byte of the gps.replay file
+//-----------------------------------------------------------------------------
+static void replay_fire(void){
+	uint8_t	c = rep[rep_idx++];
+
+	mcu_uart_rx(c);
+	if(cap) putc(c, cap);
+	ublox_stat.bytes++;
+	if(rep_idx < rep_len){
+		t_byte += 10.0L / BAUD;
+		sim_schedule(src_replay, sim_cycles(t_byte));
+	}
+}
+
+static int replay_load(const char* path){
+	FILE*	fp = fopen(path, "rb");
+	long	n;
+
+	if(!fp) return -1;
+	fseek(fp, 0, SEEK_END);
+	n = ftell(fp);
+	rewind(fp);
+	rep = (uint8_t*)malloc(n > 0 ? (size_t)n : 1);
+	if(!rep || (n <= 0) || (fread(rep, 1, (size_t)n, fp) != (size_t)n)){
+		fclose(fp);
+		free(rep);
+		rep = 0;
+		return -1;
+	}
+	fclose(fp);
+	rep_len = (uint32_t)n;
+	rep_idx = 0;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// UBX framing
+//-----------------------------------------------------------------------------
+static void put16(uint8_t* p, uint32_t v){
+
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t* p, uint32_t v){
+
+	put16(p, v);
+	put16(p + 2, v >> 16);
+}
+
+static void ubx_send(uint8_t cls, uint8_t id, const uint8_t* pay, int len){
+	uint8_t	f[8 + 256];
+	uint8_t	ck_a = 0;
+	uint8_t	ck_b = 0;
+	int		i;
+
+	f[0] = UBX_SYNC1;
+	f[1] = UBX_SYNC2;
+	f[2] = cls;
+	f[3] = id;
+	put16(f + 4, (uint32_t)len);
+	memcpy(f + 6, pay, len);
+	for(i=2; i<len+6; i++){						// Fletcher-8 over class..payload
+		ck_a += f[i];
+		ck_b += ck_a;
+	}
+	f[len + 6] = ck_a;
+	f[len + 7] = ck_b;
+	uart_send(f, len + 8);
+}
+
+//-----------------------------------------------------------------------------
+// NMEA sentences (filler traffic, content is plausible but not checked).
+//	gps.nmea = 1 sends RMC and GGA, 2 the full default u-blox set.
+//-----------------------------------------------------------------------------
+static void nmea_send(const char* body){
+	char	f[100];
+	uint8_t	ck = 0;
+	int		i;
+
+	for(i=0; body[i]; i++) ck ^= (uint8_t)body[i];
+	i = snprintf(f, sizeof(f), "$%s*%02X\r\n", body, ck);
+	uart_send((const uint8_t*)f, i);
+}
+
+static void nmea_epoch(int64_t s, int valid){
+	int64_t	utc = s - LEAP_SECONDS;
+	int		hh = (int)((utc / 3600) % 24);
+	int		mm = (int)((utc / 60) % 60);
+	int		ss = (int)(utc % 60);
+	char	b[96];
+
+	snprintf(b, sizeof(b), "GNRMC,%02d%02d%02d.00,%c,3903.12345,N,09441.54321,W,0.010,,170126,,,%c,V",
+		hh, mm, ss, valid ? 'A' : 'V', valid ? 'A' : 'N');
+	nmea_send(b);
+	snprintf(b, sizeof(b), "GNGGA,%02d%02d%02d.00,3903.12345,N,09441.54321,W,%d,12,0.71,312.4,M,-28.9,M,,",
+		hh, mm, ss, valid ? 1 : 0);
+	nmea_send(b);
+	if(sim_cfg.gps_nmea < 2) return;
+	nmea_send("GNGLL,3903.12345,N,09441.54321,W,000000.00,A,A");
+	nmea_send("GNVTG,,T,,M,0.010,N,0.019,K,A");
+	nmea_send("GNGSA,A,3,02,05,12,15,18,24,25,29,,,,,1.24,0.71,1.02,1");
+	nmea_send("GPGSV,3,1,11,02,48,296,41,05,22,181,38,12,61,054,44,15,11,042,35,1");
+	nmea_send("GPGSV,3,2,11,18,30,239,40,24,14,102,36,25,70,319,45,29,35,076,42,1");
+	nmea_send("GPGSV,3,3,11,31,05,332,28,32,02,210,,46,38,220,,1");
+}
+
+//-----------------------------------------------------------------------------
+// unrelated UBX traffic: NAV-STATUS and NAV-PVT, mostly zero payloads
+//-----------------------------------------------------------------------------
+static void nav_epoch(int64_t s, int valid){
+	uint8_t	p[PVT_LEN];
+	int64_t	tow_ms = (s % SEC_PER_WEEK) * 1000LL;
+
+	memset(p, 0, sizeof(p));
+	put32(p, (uint32_t)tow_ms);
+	p[4] = valid ? 0x05 : 0x00;					// gpsFix = time only
+	p[5] = valid ? 0x0d : 0x00;
+	ubx_send(UBX_NAV, UBX_NAV_STATUS, p, STATUS_LEN);
+	memset(p, 0, sizeof(p));
+	put32(p, (uint32_t)tow_ms);
+	p[20] = valid ? 0x05 : 0x00;				// fixType
+	p[23] = valid ? 12 : 0;						// numSV
+	ubx_send(UBX_NAV, UBX_NAV_PVT, p, PVT_LEN);
+}
+
+//-----------------------------------------------------------------------------
+// TIM-TP describes the next time pulse: qErr (ps) is true minus actual
+//-----------------------------------------------------------------------------
+static void tp_send(int64_t s){
+	uint8_t		p[TP_LEN];
+	long double	q = epoch_time(s) - tp_time(s);
+
+	memset(p, 0, sizeof(p));
+	put32(p, (uint32_t)((s % SEC_PER_WEEK) * 1000LL));
+	put32(p + 8, (uint32_t)(int32_t)llroundl(q * 1e12L));
+	put16(p + 12, (uint32_t)(s / SEC_PER_WEEK));
+	p[14] = 0x00;								// timeBase = GNSS
+	ubx_send(UBX_TIM, UBX_TIM_TP, p, TP_LEN);
+}
+
+//-----------------------------------------------------------------------------
+// tm2_send() builds a TIM-TM2 from the latched time marks.  gps.drop is the
+//	probability that a frame is lost.
+//-----------------------------------------------------------------------------
+static void tm2_stamp(uint8_t* wn, uint8_t* ms, uint8_t* subms, int64_t ns){
+	int64_t	week = ns / (SEC_PER_WEEK * 1000LL * NS_PER_MS);
+	int64_t	tow = ns - week * SEC_PER_WEEK * 1000LL * NS_PER_MS;
+
+	put16(wn, (uint32_t)week);
+	put32(ms, (uint32_t)(tow / NS_PER_MS));
+	put32(subms, (uint32_t)(tow % NS_PER_MS));
+}
+
+static int degraded(long double t){
+	return (sim_cfg.gps_deg_at >= 0.0) && (t >= sim_cfg.gps_deg_at) && (t < sim_cfg.gps_deg_at + sim_cfg.gps_deg_len);
+}
+
+static void tm2_send(int valid){
+	uint8_t	p[TM2_LEN];
+	uint8_t	flags = TMK_MODE | TMK_TB_GNSS | TMK_UTC;
+	int		deg = degraded(sim_seconds(sim_now));
+
+	memset(p, 0, sizeof(p));
+	if(valid) flags |= TMK_TVALID;
+	if(mark_r.fresh) flags |= TMK_RE;
+	if(mark_f.fresh) flags |= TMK_FE;
+	p[0] = 0;									// ch: EXTINT0
+	p[1] = flags;
+	put16(p + 2, mark_count);
+	tm2_stamp(p + 4, p + 8, p + 12, mark_r.ns);
+	tm2_stamp(p + 6, p + 16, p + 20, mark_f.ns);
+	put32(p + 24, (uint32_t)(deg ? sim_cfg.gps_deg_acc : sim_cfg.gps_acc));
+	mark_r.fresh = 0;
+	mark_f.fresh = 0;
+	if((sim_cfg.gps_drop > 0.0) && (rng_uniform(&rng) < sim_cfg.gps_drop)){
+		ublox_stat.tm2_dropped++;
+		return;
+	}
+	ubx_send(UBX_TIM, UBX_TIM_TM2, p, TM2_LEN);
+	ublox_stat.tm2++;
+	if(deg) ublox_stat.tm2_degraded++;
+}
+
+//-----------------------------------------------------------------------------
+// ublox_mark() latches an EXTINT edge on the next receiver clock tick.  The
+//	reported time carries the tick quantization plus gps.noise (scaled by
+//	gps.deg_acc / gps.acc while degraded), and a rising edge may glitch.
+//-----------------------------------------------------------------------------
+void ublox_mark(long double t, int rising){
+	tmark*		m = rising ? &mark_r : &mark_f;
+	long double	ts = tick_after(t);
+	double		sd = sim_cfg.gps_noise;
+
+	if(degraded(t) && (sim_cfg.gps_acc > 0.0)) sd *= sim_cfg.gps_deg_acc / sim_cfg.gps_acc;
+	if(sd > 0.0) ts += sd * rng_gauss(&rng);
+	if(rising && (sim_cfg.gps_glitch > 0.0) && (rng_uniform(&rng) < sim_cfg.gps_glitch)){
+		ts += (rng_uniform(&rng) < 0.5) ? -sim_cfg.gps_glitch_size : sim_cfg.gps_glitch_size;
+		ublox_stat.tm2_glitch++;
+	}
+	m->ns = (int64_t)llroundl(ublox_gps_time(ts) * 1e9L);
+	m->fresh = 1;
+	if(rising) mark_count++;
+}
+
+//-----------------------------------------------------------------------------
+// event handlers.  The time pulse for second "sec" fires at its receiver
+//	tick; the epoch output follows gps.tm2_delay after the true second.
+//-----------------------------------------------------------------------------
+static void tp_fire(void){
+	long double	t = epoch_time(sec);
+
+	if(ublox_valid(t)){
+		mcu_cex_edge(PCA_GPS, 1);
+		ublox_stat.tp++;
+	}
+	sim_schedule(src_epoch, sim_cycles(t + sim_cfg.gps_tm2_delay));
+	sec++;
+	sim_schedule(src_tp, sim_cycles(tp_time(sec)));
+}
+
+static void epoch_fire(void){
+	int64_t	s = sec - 1;
+	int		valid = ublox_valid(epoch_time(s));
+
+	if(sim_cfg.gps_timtp && valid) tp_send(s + 1);
+	if(sim_cfg.gps_ubx) nav_epoch(s, valid);
+	if(mark_r.fresh || mark_f.fresh) tm2_send(valid);
+	if(sim_cfg.gps_nmea) nmea_epoch(s, valid);
+}
+
+//-----------------------------------------------------------------------------
+// ublox_init() returns 0 if OK, -1 if gps.capture or gps.replay can't be opened
+//-----------------------------------------------------------------------------
+int ublox_init(void){
+
+	memset(&ublox_stat, 0, sizeof(ublox_stat));
+	src_tp = sim_source("gps tp", tp_fire);
+	src_epoch = sim_source("gps epoch", epoch_fire);
+	src_uart = sim_source("gps uart", uart_fire);
+	rng_seed(&rng, sim_cfg.seed, RNG_GPS);
+	gps0 = (long double)sim_cfg.gps_week * SEC_PER_WEEK + (long double)sim_cfg.gps_tow0;
+	tick = (long double)sim_cfg.gps_quant / (1.0L + (long double)sim_cfg.gps_drift);
+	tick0 = (long double)sim_cfg.gps_quant * rng_uniform(&rng);
+	sec = (int64_t)ceill(gps0);
+	memset(&mark_r, 0, sizeof(mark_r));
+	memset(&mark_f, 0, sizeof(mark_f));
+	mark_count = 0;
+	txq_head = 0;
+	txq_tail = 0;
+	sim_schedule(src_tp, sim_cycles(tp_time(sec)));
+	ublox_done();
+	if(sim_cfg.gps_capture[0]){
+		cap = fopen(sim_cfg.gps_capture, "wb");
+		if(!cap) return -1;
+	}
+	if(sim_cfg.gps_replay[0]){
+		if(replay_load(sim_cfg.gps_replay)) return -1;
+		src_replay = sim_source("gps replay", replay_fire);
+		t_byte = 10.0L / BAUD;
+		sim_schedule(src_replay, sim_cycles(t_byte));
+	}
+	return 0;
+}
+
+void ublox_done(void){
+
+	if(cap) fclose(cap);
+	cap = 0;
+	free(rep);
+	rep = 0;
+}
@@ -0,0 +1,50 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: ublox.h
+ *
+ *  Module:    Simulation
+ *
+ *  Summary:   This is the header file for the GPS receiver model (1PPS time
+ *             pulse on CEX0, EXTINT time marks reported in UBX TIM-TM2).
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  ublox_init() status, ublox_done()
+ *    10-17-26 jmh:  tm2_degraded, tm2_glitch
+ *
+ *******************************************************************/
+
+#ifndef SIM_UBLOX_H
+#define SIM_UBLOX_H
+
+#include <stdint.h>
+
+struct ublox_stats {
+	uint32_t	tp;							// time pulses
+	uint32_t	tm2;						// TIM-TM2 frames sent
+	uint32_t	tm2_dropped;				// TIM-TM2 frames lost (gps.drop)
+	uint32_t	tm2_degraded;				// TIM-TM2 frames sent with gps.deg_acc
+	uint32_t	tm2_glitch;					// time marks off by gps.glitch_size
+	uint32_t	bytes;						// UART bytes sent
+	uint32_t	corrupted;					// bytes sent with a flipped bit
+	uint32_t	tx_overflow;				// messages lost to a full output buffer
+};
+
+extern ublox_stats ublox_stat;
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+int ublox_init(void);						// 0 = OK
+void ublox_done(void);						// closes gps.capture
+void ublox_mark(long double t, int rising);	// EXTINT edge at time t (s)
+int ublox_valid(long double t);				// receiver has a time solution
+long double ublox_gps_time(long double t);	// GPS time (s since week 0) at t
+
+#endif
@@ -0,0 +1,135 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: spi.c
+ *
+ *  Module:    Control
+ *
+ *  Summary:   This is the SPI0 job queue.  Main code fills an spi_job and
+ *             posts it; spi_intr() asserts the chip select, shifts the bytes
+ *             and releases the chip select, then starts the next job.  The
+ *             main loop never waits on the bus.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  queue state in data; spi_intr() starts the next job itself (no call) and runs on
+ *					 register bank 2; job busy/done are st bits
+ *
+ *******************************************************************/
+
+#include "c8051F520.h"
+#include "typedef.h"
+#include "init.h"
+#include "spi.h"
+
+//------------------------------------------------------------------------------
+// local defines
+//------------------------------------------------------------------------------
+
+#define	SPI_QLEN	4					// job queue length (power of 2)
+#define	SPI_QMASK	(SPI_QLEN - 1)
+
+sbit CS_DAC_N   = P1^0;                         // (o) [gpio]	AD5761 SYNC
+sbit CS_TS      = P1^1;                         // (o) [gpio]	DS1722 CE
+
+//-----------------------------------------------------------------------------
+// Local Variable Declarations
+//-----------------------------------------------------------------------------
+
+spi_job idata * idata spi_q[SPI_QLEN];	// posted jobs
+data	U8	spi_qhead;					// job on the bus (or next to go)
+data	U8	spi_qtail;					// next free queue slot
+data	U8	spi_idx;					// byte on the bus
+		bit	spi_run;					// 1 = a job is on the bus
+
+//------------------------------------------------------------------------------
+// local fn declarations
+//------------------------------------------------------------------------------
+void spi_start(void);
+
+//-----------------------------------------------------------------------------
+// init_spi() empties the job queue
+//-----------------------------------------------------------------------------
+void init_spi(void){
+
+	spi_qhead = 0;
+	spi_qtail = 0;
+	spi_run = 0;
+}
+
+//-----------------------------------------------------------------------------
+// spi_post() queues a job, returns 0 if OK, 1 if the queue is full.  The job
+//	must not be touched again until SPI_BUSY clears in job->st.
+//-----------------------------------------------------------------------------
+U8 spi_post(spi_job idata* job){
+
+	if(((spi_qtail + 1) & SPI_QMASK) == spi_qhead) return 1;
+	job->st = SPI_BUSY;
+	ESPI0 = 0;										// hold off spi_intr() while the queue moves
+	spi_q[spi_qtail] = job;
+	spi_qtail = (spi_qtail + 1) & SPI_QMASK;
+	if(!spi_run) spi_start();
+	ESPI0 = 1;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// spi_start() puts the job at the queue head on the bus.  Called from
+//	spi_post() with ESPI0 off (spi_intr() does the same inline).
+//-----------------------------------------------------------------------------
+void spi_start(void){
+
+	if(spi_qhead == spi_qtail){
+		spi_run = 0;								// queue empty, bus idle
+		return;
+	}
+	spi_run = 1;
+	spi_idx = 0;
+	if(spi_q[spi_qhead]->cs == SPI_CS_TS) CS_TS = 1;
+	else CS_DAC_N = 0;
+	SPI0DAT = spi_q[spi_qhead]->buf[0];
+	return;
+}
+
+//-----------------------------------------------------------------------------
+// spi_intr
+//-----------------------------------------------------------------------------
+//
+// SPI0 intr.  One byte has been shifted: keep the MISO byte, send the next one
+//	or finish the job (release CS, flag it) and start the next queued job.
+//	The start is spi_start() written out: with no call the ISR runs on bank 2
+//	and pushes no R0-R7 (its stack frame is the return address and ACC/PSW).
+//
+//-----------------------------------------------------------------------------
+
+void spi_intr(void) interrupt 6 using 2
+{
+
+	SPIF = 0;
+	spi_q[spi_qhead]->buf[spi_idx] = SPI0DAT;
+	if(++spi_idx < spi_q[spi_qhead]->len){
+		SPI0DAT = spi_q[spi_qhead]->buf[spi_idx];
+		return;
+	}
+	CS_TS = 0;										// release the slave
+	CS_DAC_N = 1;
+	spi_q[spi_qhead]->st = SPI_DONE;
+	spi_qhead = (spi_qhead + 1) & SPI_QMASK;
+	if(spi_qhead == spi_qtail){
+		spi_run = 0;								// queue empty, bus idle
+		return;
+	}
+	spi_idx = 0;									// next job (spi_start())
+	if(spi_q[spi_qhead]->cs == SPI_CS_TS) CS_TS = 1;
+	else CS_DAC_N = 0;
+	SPI0DAT = spi_q[spi_qhead]->buf[0];
+	return;
+}
+
+//**************
+// End Of File
+//**************
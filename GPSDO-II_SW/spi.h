@@ -0,0 +1,54 @@
+/*************************************************************************
+ *********** COPYRIGHT (c) 2026 by Joseph Haas (DBA FF Systems)  *********
+ *
+ *  File name: spi.h
+ *
+ *  Module:    Control
+ *
+ *  Summary:   This is the header file for the SPI0 job queue.
+ *
+ *******************************************************************/
+
+
+/********************************************************************
+ *  File scope declarations revision history:
+ *    10-17-26 jmh:  creation date
+ *    10-17-26 jmh:  busy and done are the st bits (SPI_BUSY, SPI_DONE), one byte per job
+ *
+ *******************************************************************/
+
+//------------------------------------------------------------------------------
+// extern defines
+//------------------------------------------------------------------------------
+
+#define	SPI_JOB_MAX	3					// longest frame (AD5761 = 3 bytes)
+
+// chip selects
+#define	SPI_CS_DAC	0					// AD5761, CS_DAC_N (active low)
+#define	SPI_CS_TS	1					// DS1722, CS_TS (active high)
+
+// job status (st)
+#define	SPI_BUSY	0x01				// queued or on the bus
+#define	SPI_DONE	0x02				// finished, buf[] holds the MISO bytes
+
+// A job is owned by its poster.  buf[] goes out on MOSI and is overwritten
+//	with the bytes clocked in on MISO.  st is SPI_BUSY from spi_post() until
+//	the ISR releases the chip select, then SPI_DONE, which is left for the
+//	owner to clear.
+typedef struct {
+	U8			cs;						// SPI_CS_x
+	U8			len;					// bytes in buf[]
+	U8			buf[SPI_JOB_MAX];
+	volatile U8	st;						// SPI_BUSY, SPI_DONE
+} spi_job;
+
+//------------------------------------------------------------------------------
+// public Function Prototypes
+//------------------------------------------------------------------------------
+
+void init_spi(void);
+U8 spi_post(spi_job idata* job);
+
+//------------------------------------------------------------------------------
+// global defines
+//------------------------------------------------------------------------------